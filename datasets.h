@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <string_view>
+#include <vector>
+
+// Synthetic corpora resembling production columns.
+// Uniform covers the whole range of the type and is practically incompressible, it is kept as the worst case.
+enum class Distribution {
+    Uniform,
+    RandomWalk,
+    SensorSignal,
+    Sparse,
+    IntegerValued,
+    PriceTicks,
+    MLWeights,
+};
+
+inline constexpr std::array DISTRIBUTIONS{
+    Distribution::Uniform,
+    Distribution::RandomWalk,
+    Distribution::SensorSignal,
+    Distribution::Sparse,
+    Distribution::IntegerValued,
+    Distribution::PriceTicks,
+    Distribution::MLWeights,
+};
+
+inline std::string_view DistributionName(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::Uniform:
+            return "uniform";
+        case Distribution::RandomWalk:
+            return "random_walk";
+        case Distribution::SensorSignal:
+            return "sensor";
+        case Distribution::Sparse:
+            return "sparse";
+        case Distribution::IntegerValued:
+            return "integer";
+        case Distribution::PriceTicks:
+            return "price_ticks";
+        case Distribution::MLWeights:
+            return "ml_weights";
+    }
+    return "unknown";
+}
+
+template <typename Float>
+std::vector<Float> GenTest(std::size_t bytes, Distribution distribution, std::uint64_t seed = 1488) {
+    std::mt19937_64 rnd{seed};
+    std::vector<Float> inp;
+    auto count = bytes / sizeof(Float);
+    inp.reserve(count);
+    switch (distribution) {
+        case Distribution::Uniform: {
+            std::uniform_real_distribution<Float> val_dist(
+                std::numeric_limits<Float>::min(), std::numeric_limits<Float>::max());
+            while (inp.size() < count)
+                inp.push_back(val_dist(rnd));
+            break;
+        }
+        case Distribution::RandomWalk: {
+            std::normal_distribution<Float> step_dist(0, 1);
+            Float value{1000};
+            while (inp.size() < count)
+                inp.push_back(value += step_dist(rnd));
+            break;
+        }
+        case Distribution::SensorSignal: {
+            // Daily temperature-like cycle sampled every second with a little measurement noise
+            std::normal_distribution<Float> noise_dist(0, Float(0.05));
+            for (std::size_t i = 0; i < count; ++i) {
+                auto phase = 2 * std::numbers::pi_v<Float> * static_cast<Float>(i % 86400) / 86400;
+                inp.push_back(20 + 5 * std::sin(phase) + noise_dist(rnd));
+            }
+            break;
+        }
+        case Distribution::Sparse: {
+            std::bernoulli_distribution nonzero_dist(0.05);
+            std::normal_distribution<Float> val_dist(0, 100);
+            while (inp.size() < count)
+                inp.push_back(nonzero_dist(rnd) ? val_dist(rnd) : Float{0});
+            break;
+        }
+        case Distribution::IntegerValued: {
+            std::geometric_distribution<std::int64_t> val_dist(0.001);
+            while (inp.size() < count)
+                inp.push_back(static_cast<Float>(val_dist(rnd)));
+            break;
+        }
+        case Distribution::PriceTicks: {
+            // Prices with two decimal digits moving by a few cents per tick
+            std::uniform_int_distribution<std::int64_t> tick_dist(-2, 2);
+            std::int64_t cents{10000};
+            while (inp.size() < count) {
+                cents = std::max<std::int64_t>(1, cents + tick_dist(rnd));
+                inp.push_back(static_cast<Float>(cents) / 100);
+            }
+            break;
+        }
+        case Distribution::MLWeights: {
+            // Float32 weights, widened when the requested type is wider
+            std::normal_distribution<float> val_dist(0, 0.02f);
+            while (inp.size() < count)
+                inp.push_back(static_cast<Float>(val_dist(rnd)));
+            break;
+        }
+    }
+    return inp;
+}
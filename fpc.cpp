@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fpc_codec.h"
+#include "io_queue.h"
+
+namespace {
+
+// Files are codec frames (see doCompressFrame): independent checksummed blocks, compressed and decompressed
+// in parallel
+
+// Minimal number of blocks being read, compressed or written at the same time in pipeline mode
+constexpr std::size_t PIPELINE_DEPTH{4};
+
+enum class Mode {
+    Mmap,
+    Pipeline,
+    Sequential,
+};
+
+struct Options {
+    bool decompress{false};
+    bool verbose{false};
+    Mode mode{Mode::Mmap};
+    UInt8 float_width{8};
+    UInt8 level{12};
+    unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+    UInt32 block_size{4 << 20};
+    const char* input{nullptr};
+    const char* output{nullptr};
+};
+
+// Width and level accepted on the command line and in file headers
+bool IsValidCodec(UInt8 float_width, UInt8 level) {
+    return (float_width == sizeof(Float32) || float_width == sizeof(Float64)) && level >= 1
+        && level <= DB::CompressionCodecFPC::MAX_COMPRESSION_LEVEL;
+}
+
+[[noreturn]] void ThrowErrno(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+class File {
+public:
+    File(const char* path, int flags, mode_t mode = 0644)
+        : fd{::open(path, flags, mode)} {
+        if (fd < 0)
+            ThrowErrno(path);
+    }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File() {
+        ::close(fd);
+    }
+
+    [[nodiscard]]
+    std::size_t size() const {
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+            ThrowErrno("fstat");
+        return static_cast<std::size_t>(st.st_size);
+    }
+
+    void resize(std::size_t size) const {
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+            ThrowErrno("ftruncate");
+    }
+
+    [[nodiscard]]
+    int descriptor() const noexcept {
+        return fd;
+    }
+
+private:
+    int fd;
+};
+
+class Mapping {
+public:
+    Mapping(const File& file, std::size_t size, bool writable)
+        : length{size} {
+        if (length == 0)
+            return;
+        auto protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        auto* addr = ::mmap(nullptr, length, protection, MAP_SHARED, file.descriptor(), 0);
+        if (addr == MAP_FAILED)
+            ThrowErrno("mmap");
+        data = static_cast<char*>(addr);
+        ::madvise(data, length, MADV_SEQUENTIAL);
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+        if (data != nullptr)
+            ::munmap(data, length);
+    }
+
+    char* data{nullptr};
+    std::size_t length;
+};
+
+void Compress(const Options& options) {
+    File input(options.input, O_RDONLY);
+    auto uncompressed_size = input.size();
+    Mapping source(input, uncompressed_size, false);
+
+    DB::CompressionCodecFPC codec(options.float_width, options.level);
+    auto max_size = codec.getMaxCompressedFrameSize(uncompressed_size, options.block_size);
+    File output(options.output, O_RDWR | O_CREAT | O_TRUNC);
+    output.resize(max_size);
+    UInt64 compressed_size{0};
+    {
+        Mapping dest(output, max_size, true);
+        compressed_size = codec.doCompressFrame(
+            source.data, uncompressed_size, dest.data, DB::FrameChecksum::Both, options.threads, options.block_size);
+    }
+    output.resize(compressed_size);
+}
+
+std::size_t BlockSize(std::size_t block_size, std::size_t uncompressed_size, std::size_t block) {
+    return std::min<std::size_t>(block_size, uncompressed_size - block * block_size);
+}
+
+// Streams blocks through a ring of reusable buffers: while a round of blocks is compressed on the pool,
+// the following ones are being read and the previous ones are being written. The ring holds two rounds,
+// so the next round is read while the current one is compressed
+void CompressPipeline(const Options& options) {
+    File input(options.input, O_RDONLY);
+    auto uncompressed_size = input.size();
+    File output(options.output, O_RDWR | O_CREAT | O_TRUNC);
+
+    DB::CompressionCodecFPC codec(options.float_width, options.level);
+    auto block_size = codec.getFrameBlockSize(options.block_size);
+    auto block_count = (uncompressed_size + block_size - 1) / block_size;
+    std::array<char, DB::CompressionCodecFPC::FRAME_HEADER_SIZE> header{};
+    codec.doCompressFrameHeader(uncompressed_size, header.data(), DB::FrameChecksum::Both, block_size);
+
+    struct Slot {
+        std::vector<char> source;
+        std::vector<char> dest;
+        bool read{false};
+    };
+    std::vector<Slot> slots(std::min(std::max<std::size_t>(PIPELINE_DEPTH, 2 * options.threads), block_count));
+    for (auto& slot : slots) {
+        slot.source.resize(block_size);
+        slot.dest.resize(codec.getMaxCompressedFrameBlockSize(block_size));
+    }
+
+    // Tags are 2 * block for reads and 2 * block + 1 for writes
+    static constexpr auto HEADER_TAG = std::numeric_limits<std::size_t>::max();
+    auto queue = IoQueue::create(static_cast<unsigned>(2 * slots.size() + 1));
+    auto read_block = [&](std::size_t block) {
+        queue->read(input.descriptor(), slots[block % slots.size()].source.data(),
+                    BlockSize(block_size, uncompressed_size, block), static_cast<off_t>(block * block_size), 2 * block);
+    };
+
+    queue->write(output.descriptor(), header.data(), header.size(), 0, HEADER_TAG);
+    for (std::size_t block = 0; block < slots.size(); ++block)
+        read_block(block);
+
+    std::size_t compressed_blocks{0};
+    std::size_t written_blocks{0};
+    bool header_written{false};
+    std::vector<DB::FrameBlockTask> tasks;
+    auto write_offset = static_cast<off_t>(header.size());
+    while (written_blocks < block_count || !header_written) {
+        auto tag = queue->wait();
+        if (tag == HEADER_TAG) {
+            header_written = true;
+        } else if (tag % 2 == 0) {
+            slots[tag / 2 % slots.size()].read = true;
+        } else {
+            ++written_blocks;
+            // The slot is free again, it is reused by the block which is a ring size further
+            if (auto next = tag / 2 + slots.size(); next < block_count)
+                read_block(next);
+        }
+
+        // A round starts once there is a read block for every thread, or for every remaining block
+        std::size_t ready{0};
+        while (compressed_blocks + ready < block_count && ready < slots.size()
+               && slots[(compressed_blocks + ready) % slots.size()].read)
+            ++ready;
+        if (ready == 0 || ready < std::min<std::size_t>(options.threads, block_count - compressed_blocks))
+            continue;
+
+        tasks.clear();
+        for (std::size_t i = 0; i < ready; ++i) {
+            auto block = compressed_blocks + i;
+            auto& slot = slots[block % slots.size()];
+            tasks.push_back({slot.source.data(), static_cast<UInt32>(BlockSize(block_size, uncompressed_size, block)),
+                             slot.dest.data(), 0});
+        }
+        codec.doCompressFrameBlocks(tasks, DB::FrameChecksum::Both, options.threads);
+        for (const auto& task : tasks) {
+            auto& slot = slots[compressed_blocks % slots.size()];
+            slot.read = false;
+            queue->write(output.descriptor(), task.dest, task.compressed_size, write_offset, 2 * compressed_blocks + 1);
+            write_offset += static_cast<off_t>(task.compressed_size);
+            ++compressed_blocks;
+        }
+    }
+}
+
+// Baseline for the pipeline: every read, compression and write waits for the previous one
+void CompressSequential(const Options& options) {
+    File input(options.input, O_RDONLY);
+    auto uncompressed_size = input.size();
+    File output(options.output, O_RDWR | O_CREAT | O_TRUNC);
+
+    DB::CompressionCodecFPC codec(options.float_width, options.level);
+    auto block_size = codec.getFrameBlockSize(options.block_size);
+    auto block_count = (uncompressed_size + block_size - 1) / block_size;
+    std::array<char, DB::CompressionCodecFPC::FRAME_HEADER_SIZE> header{};
+    codec.doCompressFrameHeader(uncompressed_size, header.data(), DB::FrameChecksum::Both, block_size);
+
+    std::vector<char> source(block_size);
+    std::vector<char> dest(codec.getMaxCompressedFrameBlockSize(block_size));
+    ThreadIoQueue queue;
+    queue.write(output.descriptor(), header.data(), header.size(), 0, 0);
+    queue.wait();
+
+    auto write_offset = static_cast<off_t>(header.size());
+    for (std::size_t block = 0; block < block_count; ++block) {
+        DB::FrameBlockTask task{
+            source.data(), static_cast<UInt32>(BlockSize(block_size, uncompressed_size, block)), dest.data(), 0};
+        queue.read(input.descriptor(), source.data(), task.source_size, static_cast<off_t>(block * block_size), 0);
+        queue.wait();
+        codec.doCompressFrameBlocks(std::span(&task, 1));
+        queue.write(output.descriptor(), dest.data(), task.compressed_size, write_offset, 0);
+        queue.wait();
+        write_offset += static_cast<off_t>(task.compressed_size);
+    }
+}
+
+void Decompress(const Options& options) {
+    File input(options.input, O_RDONLY);
+    auto compressed_size = input.size();
+    Mapping source(input, compressed_size, false);
+
+    // Reads and checks the whole frame header, the width and level follow the magic
+    auto uncompressed_size = DB::CompressionCodecFPC::getFrameUncompressedSize(source.data, compressed_size);
+    auto float_width = static_cast<UInt8>(source.data[4]);
+    auto level = static_cast<UInt8>(source.data[5]);
+    if (!IsValidCodec(float_width, level))
+        throw std::runtime_error("Input has unsupported float width or level");
+
+    DB::CompressionCodecFPC codec(float_width, level);
+    File output(options.output, O_RDWR | O_CREAT | O_TRUNC);
+    output.resize(uncompressed_size);
+    Mapping dest(output, uncompressed_size, true);
+    codec.doDecompressFrame(source.data, compressed_size, dest.data, uncompressed_size, options.threads);
+}
+
+[[noreturn]] void Usage() {
+    std::fputs(
+        "Usage: fpc [-d] [-v] [-w width] [-l level] [-t threads] [-b block_size] [-m mode] <input> <output>\n"
+        "  -d  decompress instead of compress\n"
+        "  -w  float width in bytes, 4 or 8 (default 8)\n"
+        "  -l  compression level (default 12)\n"
+        "  -t  number of threads (default: hardware concurrency)\n"
+        "  -b  uncompressed block size in bytes (default 4 MiB)\n"
+        "  -m  compression mode: mmap (default), pipeline (block reads and writes overlapped with compression\n"
+        "      on the threads)\n"
+        "      or sequential (blocking reads and writes, baseline for pipeline)\n"
+        "  -v  print throughput to stderr\n",
+        stderr);
+    std::exit(2);
+}
+
+Options ParseOptions(std::span<char*> args) {
+    Options options;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        std::string_view arg(args[i]);
+        // Whole decimal numbers only, checked against the range of the option before it is narrowed
+        auto next = [&](unsigned long long max) {
+            if (i + 1 >= args.size())
+                Usage();
+            const char* value = args[++i];
+            char* end = nullptr;
+            errno = 0;
+            auto number = std::strtoull(value, &end, 10);
+            if (end == value || *end != '\0' || errno == ERANGE || number > max)
+                Usage();
+            return number;
+        };
+        if (arg == "-d") {
+            options.decompress = true;
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (arg == "-m") {
+            if (++i >= args.size())
+                Usage();
+            std::string_view mode(args[i]);
+            if (mode == "mmap")
+                options.mode = Mode::Mmap;
+            else if (mode == "pipeline")
+                options.mode = Mode::Pipeline;
+            else if (mode == "sequential")
+                options.mode = Mode::Sequential;
+            else
+                Usage();
+        } else if (arg == "-w") {
+            options.float_width = static_cast<UInt8>(next(std::numeric_limits<UInt8>::max()));
+        } else if (arg == "-l") {
+            options.level = static_cast<UInt8>(next(std::numeric_limits<UInt8>::max()));
+        } else if (arg == "-t") {
+            options.threads = static_cast<unsigned>(next(std::numeric_limits<unsigned>::max()));
+        } else if (arg == "-b") {
+            options.block_size = static_cast<UInt32>(next(std::numeric_limits<UInt32>::max()));
+        } else if (!options.input) {
+            options.input = args[i];
+        } else if (!options.output) {
+            options.output = args[i];
+        } else {
+            Usage();
+        }
+    }
+    if (!options.input || !options.output || options.threads == 0)
+        Usage();
+    if (!IsValidCodec(options.float_width, options.level))
+        Usage();
+    if (options.block_size == 0 || options.block_size % options.float_width != 0
+        || options.block_size > DB::CompressionCodecFPC::MAX_FRAME_BLOCK_SIZE)
+        Usage();
+    return options;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    auto options = ParseOptions(std::span(argv, argc));
+    try {
+        auto start = std::chrono::steady_clock::now();
+        if (options.decompress) {
+            Decompress(options);
+        } else {
+            switch (options.mode) {
+                case Mode::Mmap:
+                    Compress(options);
+                    break;
+                case Mode::Pipeline:
+                    CompressPipeline(options);
+                    break;
+                case Mode::Sequential:
+                    CompressSequential(options);
+                    break;
+            }
+        }
+        auto fin = std::chrono::steady_clock::now();
+
+        if (options.verbose) {
+            struct stat st{};
+            ::stat(options.decompress ? options.output : options.input, &st);
+            auto seconds = std::chrono::duration<double>(fin - start).count();
+            std::fprintf(stderr, "%.3f s, %.1f MB/s of uncompressed data\n",
+                         seconds, static_cast<double>(st.st_size) / (1024 * 1024) / seconds);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "fpc: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -1,8 +1,31 @@
+#pragma once
+
 #include <span>
 #include <bit>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <concepts>
+#include <coroutine>
+#include <cstdlib>
 #include <cstring>
 #include <climits>
+#include <cmath>
+#include <stdexcept>
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
 
 using UInt8 = std::uint8_t;
 using UInt32 = std::uint32_t;
@@ -17,21 +40,666 @@ std::runtime_error Exception(Args&&...) {
 
 namespace DB {
 
+// Encoder statistics policy which is compiled out, used by default
+struct NoEncoderStatistics {
+    void addValue(bool /*is_dfcm_predictor*/, unsigned /*encoded_size*/) noexcept {}
+    void addBytes(std::size_t /*bytes*/) noexcept {}
+    NoEncoderStatistics& operator+=(const NoEncoderStatistics&) noexcept { return *this; }
+};
+
+// Explains the achieved compression: which predictor won and how many leading zero bytes were dropped
+struct EncoderStatistics {
+    UInt64 values{0};
+    UInt64 dfcm_wins{0};
+    UInt64 fcm_wins{0};
+    // Indexed by the 3-bit encoded compressed size stored in the pair header
+    std::array<UInt64, 8> encoded_size_histogram{};
+    // Compressed bytes emitted for values, without the codec header
+    UInt64 bytes{0};
+
+    [[nodiscard]]
+    double bytesPerValue() const noexcept {
+        return values == 0 ? 0.0 : static_cast<double>(bytes) / static_cast<double>(values);
+    }
+
+    void addValue(bool is_dfcm_predictor, unsigned encoded_size) noexcept {
+        ++values;
+        ++(is_dfcm_predictor ? dfcm_wins : fcm_wins);
+        ++encoded_size_histogram[encoded_size];
+    }
+
+    void addBytes(std::size_t count) noexcept {
+        bytes += count;
+    }
+
+    EncoderStatistics& operator+=(const EncoderStatistics& other) noexcept {
+        values += other.values;
+        dfcm_wins += other.dfcm_wins;
+        fcm_wins += other.fcm_wins;
+        for (std::size_t i = 0; i < encoded_size_histogram.size(); ++i)
+            encoded_size_histogram[i] += other.encoded_size_histogram[i];
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+struct CompressionEstimate {
+    // Estimated result of doCompressData, header included
+    UInt32 compressed_size;
+    double ratio;
+    // Half-width of the ~95% confidence interval of ratio, zero when the whole input was inspected
+    double ratio_error;
+};
+
+// Which bytes of every block of a frame are covered by an xxHash64 checksum
+enum class FrameChecksum : UInt8 {
+    None = 0,
+    Compressed = 1,
+    Uncompressed = 2,
+    Both = 3,
+};
+
+// Minimal single-pass generator, std::generator is only available since C++23.
+// The yielded value is referenced, not copied, and stays valid until the iterator is advanced.
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        const T* value{nullptr};
+        std::exception_ptr exception;
+
+        Generator get_return_object() noexcept {
+            return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_always yield_value(const T& yielded) noexcept {
+            value = std::addressof(yielded);
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() noexcept {
+            exception = std::current_exception();
+        }
+    };
+
+    class Iterator {
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        const T& operator*() const noexcept {
+            return *coroutine.promise().value;
+        }
+
+        Iterator& operator++() {
+            resume(coroutine);
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        bool operator==(std::default_sentinel_t) const noexcept {
+            return coroutine.done();
+        }
+
+    private:
+        friend class Generator;
+
+        explicit Iterator(std::coroutine_handle<promise_type> handle) noexcept
+            : coroutine{handle} {
+        }
+
+        std::coroutine_handle<promise_type> coroutine{};
+    };
+
+    Generator(Generator&& other) noexcept
+        : coroutine{std::exchange(other.coroutine, {})} {
+    }
+
+    Generator& operator=(Generator other) noexcept {
+        std::swap(coroutine, other.coroutine);
+        return *this;
+    }
+
+    ~Generator() {
+        if (coroutine)
+            coroutine.destroy();
+    }
+
+    // Runs the body up to the first value, may be called once
+    Iterator begin() {
+        resume(coroutine);
+        return Iterator{coroutine};
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) noexcept
+        : coroutine{handle} {
+    }
+
+    static void resume(std::coroutine_handle<promise_type> handle) {
+        handle.resume();
+        if (handle.done() && handle.promise().exception)
+            std::rethrow_exception(std::exchange(handle.promise().exception, {}));
+    }
+
+    std::coroutine_handle<promise_type> coroutine;
+};
+
+// Single-pass std::ranges input view over decoded values, returned by CompressionCodecFPC::decodedView.
+// Values are decoded a pair at a time when the iterator reaches them, so find_if, views::take or views::filter
+// stop decoding where they stop reading. The view is move-only, pass it to range adaptors by std::move.
+template <typename Float>
+class DecodedView : public std::ranges::view_interface<DecodedView<Float>> {
+public:
+    class Iterator {
+    public:
+        using value_type = Float;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        Float operator*() const noexcept {
+            return (*view->pair)[view->position];
+        }
+
+        Iterator& operator++() {
+            if (++view->position == (*view->pair).size()) {
+                ++view->pair;
+                view->position = 0;
+            }
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        bool operator==(std::default_sentinel_t) const noexcept {
+            return view->pair == std::default_sentinel;
+        }
+
+    private:
+        friend class DecodedView;
+
+        explicit Iterator(DecodedView* parent) noexcept
+            : view{parent} {
+        }
+
+        DecodedView* view{nullptr};
+    };
+
+    explicit DecodedView(Generator<std::span<const Float>> decoded_pairs) noexcept
+        : pairs{std::move(decoded_pairs)} {
+    }
+
+    // Decodes the first pair, may be called once
+    Iterator begin() {
+        pair = pairs.begin();
+        return Iterator{this};
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+
+private:
+    Generator<std::span<const Float>> pairs;
+    typename Generator<std::span<const Float>>::Iterator pair{};
+    std::size_t position{0};
+};
+
+// One doCompressData output of a batch passed to doDecompressBatch
+struct DecompressionTask {
+    const char* source;
+    UInt32 source_size;
+    char* dest;
+    UInt32 uncompressed_size;
+};
+
+// One block of a frame compressed by doCompressFrameBlocks
+struct FrameBlockTask {
+    const char* source;
+    UInt32 source_size;
+    char* dest;
+    // Set by doCompressFrameBlocks, the block prefix and checksums included
+    UInt32 compressed_size;
+};
+
+// Comparison of decoded values against a constant evaluated by decompressFilter
+enum class Comparison : UInt8 {
+    Less,
+    LessOrEquals,
+    Greater,
+    GreaterOrEquals,
+    Equals,
+    NotEquals,
+};
+
+// Predictor tables trained on representative values. A codec constructed with a snapshot starts every
+// doCompressData stream from it instead of from empty tables, which pays off on blocks too small to warm the
+// tables up. Streams record the snapshot id and decode only with the same snapshot. Frames are not affected.
+class PredictorSnapshot {
+public:
+    // Runs the predictors of float_width and level over source as the encoder would. The training tables
+    // and the kept state are allocated from resource
+    static PredictorSnapshot train(
+        UInt8 float_width,
+        UInt8 level,
+        UInt32 id,
+        const char* source,
+        UInt32 source_size,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    static PredictorSnapshot deserialize(
+        const char* source,
+        std::size_t source_size,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    std::size_t getSerializedSize() const noexcept;
+
+    void serialize(char* dest) const;
+
+    UInt32 getId() const noexcept {
+        return id;
+    }
+
+    UInt8 getFloatWidth() const noexcept {
+        return float_width;
+    }
+
+    UInt8 getLevel() const noexcept {
+        return level;
+    }
+
+    // Magic, float width, level, endianness, a reserved byte and the id
+    static constexpr std::size_t SERIALIZED_HEADER_SIZE{12};
+
+private:
+    friend class CompressionCodecFPC;
+
+    PredictorSnapshot(
+        UInt8 snapshot_float_width,
+        UInt8 snapshot_level,
+        UInt32 snapshot_id,
+        std::pmr::memory_resource* resource);
+
+    UInt8 float_width;
+    UInt8 level;
+    UInt32 id;
+    std::pmr::vector<std::byte> state;
+};
+
+// Encoder end state of an appendable stream: predictor tables after the last complete pair, the value left
+// in the padded last pair of an odd count, and the stream sizes. Kept or serialized next to the compressed data,
+// it lets doAppendData continue the stream at the cost of the new values only. The predictor tables are allocated
+// from the memory resource of the codec that filled the state, or the one passed to deserialize.
+class AppendState {
+public:
+    // Empty state, filled by doCompressData
+    AppendState() = default;
+
+    AppendState(AppendState&& other) noexcept = default;
+
+    // Takes over the tables of other together with their memory resource, where pmr containers would copy
+    // them into the resource of this state
+    AppendState& operator=(AppendState&& other) noexcept;
+
+    // Copies are allocated from the default resource
+    AppendState(const AppendState& other) = default;
+    AppendState& operator=(const AppendState& other) = default;
+
+    static AppendState deserialize(
+        const char* source,
+        std::size_t source_size,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    std::size_t getSerializedSize() const noexcept;
+
+    void serialize(char* dest) const;
+
+    UInt32 getUncompressedSize() const noexcept {
+        return uncompressed_size;
+    }
+
+    UInt32 getCompressedSize() const noexcept {
+        return compressed_size;
+    }
+
+    // Magic, float width, level, endianness, pending flag, sizes and the pending value
+    static constexpr std::size_t SERIALIZED_HEADER_SIZE{28};
+
+private:
+    friend class CompressionCodecFPC;
+
+    AppendState(UInt8 state_float_width, UInt8 state_level, std::pmr::memory_resource* resource);
+
+    UInt8 float_width{0};
+    UInt8 level{0};
+    bool has_pending{false};
+    UInt32 uncompressed_size{0};
+    UInt32 compressed_size{0};
+    // Stream size up to the pair holding the pending value
+    UInt32 pairs_size{0};
+    UInt64 pending_value{0};
+    std::pmr::vector<std::byte> predictor_state;
+};
+
+// Encodings tried on every doCompressData block before plain FPC, flags combine. The chosen encoding is
+// recorded in the stream header, so every decoder of any codec with the same width and level reads it.
+// doCompressStrided and appendable streams never use them, their output is always plain FPC.
+enum class BlockEncodings : UInt8 {
+    None = 0,
+    // Float64 blocks whose values all equal k / 10^e for one exponent e are stored as the integers k,
+    // delta coded by the FPC predictors. Values are verified to round trip exactly before the choice is made
+    Decimal = 1 << 0,
+    // Float64 blocks whose values all convert to Float32 and back unchanged are encoded as Float32,
+    // halving the values passed through the predictors. Tried after Decimal
+    Downcast = 1 << 1,
+};
+
+constexpr BlockEncodings operator|(BlockEncodings lhs, BlockEncodings rhs) noexcept {
+    return static_cast<BlockEncodings>(static_cast<UInt8>(lhs) | static_cast<UInt8>(rhs));
+}
+
+constexpr bool operator&(BlockEncodings lhs, BlockEncodings rhs) noexcept {
+    return (static_cast<UInt8>(lhs) & static_cast<UInt8>(rhs)) != 0;
+}
+
 class CompressionCodecFPC {
 public:
-    CompressionCodecFPC(UInt8 float_size, UInt8 compression_level);
+    // Float width must be 4 or 8 and level within 1..MAX_COMPRESSION_LEVEL, otherwise ILLEGAL_CODEC_PARAMETER
+    CompressionCodecFPC(
+        UInt8 float_size,
+        UInt8 compression_level,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Not combined with predictor snapshots
+    CompressionCodecFPC(
+        UInt8 float_size,
+        UInt8 compression_level,
+        BlockEncodings encodings,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Float width and level are the ones of the snapshot, which must outlive the codec
+    explicit CompressionCodecFPC(
+        const PredictorSnapshot& snapshot,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     UInt32 doCompressData(const char* source, UInt32 source_size, char* dest) const;
 
+    // Same as above, additionally accumulates encoder statistics into statistics. They describe the values
+    // passed through the predictors, which are the Float32 or integer values in encoded blocks
+    UInt32 doCompressData(const char* source, UInt32 source_size, char* dest, EncoderStatistics& statistics) const;
+
     void doDecompressData(const char* source, UInt32 source_size, char* dest, UInt32 uncompressed_size) const;
 
+    // Appendable streams. Output is the same as above and state receives the encoder end state.
+    // doAppendData encodes source onto the stream in dest described by state, dest must have room for
+    // getMaxCompressedDataSize(state.getUncompressedSize() + source_size) bytes. The result equals doCompressData
+    // of all values at once and is returned with the new compressed size. Sizes must hold whole values.
+    UInt32 doCompressData(const char* source, UInt32 source_size, char* dest, AppendState& state) const;
+
+    UInt32 doAppendData(const char* source, UInt32 source_size, char* dest, AppendState& state) const;
+
+    // Rebuilds the end state of a doCompressData stream by decoding it, when the state was not kept
+    AppendState recoverAppendState(const char* source, UInt32 source_size, UInt32 uncompressed_size) const;
+
+    // In-place decoding without a separate compressed buffer: the doCompressData output of source_size bytes
+    // occupies the tail of buffer, the values are decoded to its front. Decoded chunks are written only over
+    // input that has already been read, which holds when buffer_size is at least
+    // uncompressed_size + getInPlaceDecompressionMargin(uncompressed_size).
+    void doDecompressInPlace(char* buffer, UInt32 buffer_size, UInt32 source_size, UInt32 uncompressed_size) const;
+
+    // Decodes independent doCompressData outputs of this codec, the result is the same as doDecompressData
+    // for every task. Streams are decoded in groups of 8 interleaved value by value, so their serially
+    // dependent predictor chains overlap. That needs the tables of a whole group in L2, at levels above 12
+    // (13 for Float32) streams are decoded one after another.
+    void doDecompressBatch(std::span<const DecompressionTask> tasks) const;
+
+    // Strided views: value i lives at source + i * stride bytes, e.g. a field of an array of structs
+    // or the real parts of complex numbers. Values are gathered and scattered chunk by chunk without
+    // temporary buffers. Block encodings are not tried, the output is the same as doCompressData of count
+    // contiguous values by a codec without them and is bounded by getMaxCompressedDataSize(count * float width).
+    UInt32 doCompressStrided(const char* source, std::size_t stride, UInt32 count, char* dest) const;
+
+    void doDecompressStrided(const char* source, UInt32 source_size, char* dest, std::size_t stride, UInt32 count) const;
+
+    // Decodes at most max_values leading values into dest, which must hold max_values floats, and returns
+    // the number of decoded values. The uncompressed size is not needed, decoding stops at the end of source
+    // and no compressed bytes past the requested values are read. Values are stored in pairs, so when the
+    // original data had an odd number of values, reading to the end yields the padding as one more value:
+    // zero, or a repeat of the last value in decimal blocks.
+    UInt32 decompressPrefix(const char* source, UInt32 source_size, char* dest, UInt32 max_values) const;
+
+    // Fused decode and scan: values are passed to func as std::span<const Float> chunk by chunk while they are
+    // still in L1, the decompressed array is never written. Float must match the float width of the codec,
+    // a trailing partial value of uncompressed_size is ignored.
+    template <std::floating_point Float, typename Func>
+    void decompressForEach(const char* source, UInt32 source_size, UInt32 uncompressed_size, Func&& func) const;
+
+    // Lazy decoding for pull-based consumers: yields successive chunks of ChunkSize decoded values, a trailing
+    // partial value of uncompressed_size is dropped. Chunks view one buffer reused for the whole stream, nothing
+    // is allocated per chunk. The header is checked eagerly, decoding errors are thrown from the iterator.
+    // source must outlive the generator.
+    template <std::floating_point Float, std::size_t ChunkSize = 64>
+    Generator<std::span<const Float>> decompressChunks(
+        const char* source,
+        UInt32 source_size,
+        UInt32 uncompressed_size) const;
+
+    // Lazy std::ranges input view over the decoded values, header and width are validated eagerly
+    template <std::floating_point Float>
+    DecodedView<Float> decodedView(const char* source, UInt32 source_size, UInt32 uncompressed_size) const;
+
+    // Aggregations over decompressForEach. The sum is accumulated in Float64 by several partial sums,
+    // min and max skip NaNs and return +inf and -inf respectively when there are no values.
+    template <std::floating_point Float>
+    Float64 decompressSum(const char* source, UInt32 source_size, UInt32 uncompressed_size) const;
+
+    template <std::floating_point Float>
+    Float decompressMin(const char* source, UInt32 source_size, UInt32 uncompressed_size) const;
+
+    template <std::floating_point Float>
+    Float decompressMax(const char* source, UInt32 source_size, UInt32 uncompressed_size) const;
+
+    template <std::floating_point Float, typename Predicate>
+    UInt64 decompressCountIf(
+        const char* source,
+        UInt32 source_size,
+        UInt32 uncompressed_size,
+        Predicate&& predicate) const;
+
+    // Predicate pushdown: bit i % 64 of bitmap[i / 64] is set when value i satisfies predicate, bits past the last
+    // value are zero. bitmap must hold getSelectionBitmapSize words. Returns the number of selected values.
+    template <std::floating_point Float, typename Predicate>
+    UInt64 decompressSelect(
+        const char* source,
+        UInt32 source_size,
+        UInt32 uncompressed_size,
+        Predicate&& predicate,
+        UInt64* bitmap) const;
+
+    // decompressSelect for value <comparison> constant, every comparison is instantiated as a separate kernel
+    template <std::floating_point Float>
+    UInt64 decompressFilter(
+        const char* source,
+        UInt32 source_size,
+        UInt32 uncompressed_size,
+        Comparison comparison,
+        Float constant,
+        UInt64* bitmap) const;
+
+    UInt32 getSelectionBitmapSize(UInt32 uncompressed_size) const;
+
     UInt32 getMaxCompressedDataSize(UInt32 uncompressed_size) const;
 
+    // Bytes past the decoded values that doDecompressInPlace needs in its buffer
+    UInt32 getInPlaceDecompressionMargin(UInt32 uncompressed_size) const;
+
+    // Runs the predictors over strided windows of source without emitting output, starting from the predictor
+    // snapshot if any. Windows are converted by the block encoding doCompressData would choose for them
+    CompressionEstimate estimateCompressedSize(const char* source, UInt32 source_size) const;
+
+    // Framed format: a header with the 64-bit total size, then blocks carrying their compressed size and checksums.
+    // Checksums are computed by the encode and decode loops and verified by doDecompressFrame.
+    // Blocks are independent and are processed by up to threads threads, memory_resource must then be thread-safe.
+    // Every thread allocates its predictor tables once and clears them for each block of block_size bytes,
+    // see getFrameBlockSize.
+    UInt64 doCompressFrame(
+        const char* source,
+        UInt64 source_size,
+        char* dest,
+        FrameChecksum checksum = FrameChecksum::Both,
+        unsigned threads = 1,
+        UInt32 block_size = 0) const;
+
+    void doDecompressFrame(
+        const char* source,
+        UInt64 source_size,
+        char* dest,
+        UInt64 uncompressed_size,
+        unsigned threads = 1) const;
+
+    UInt64 getMaxCompressedFrameSize(UInt64 uncompressed_size, UInt32 block_size = 0) const;
+
+    // Frames written block by block, e.g. while further input is still being read: the header written here,
+    // then the blocks of doCompressFrameBlocks in order, all but the last of getFrameBlockSize(block_size) bytes.
+    // The result equals doCompressFrame of the whole input. Returns FRAME_HEADER_SIZE.
+    UInt32 doCompressFrameHeader(
+        UInt64 source_size,
+        char* dest,
+        FrameChecksum checksum = FrameChecksum::Both,
+        UInt32 block_size = 0) const;
+
+    // Compresses independent blocks on up to threads threads, dest of a task must have room for
+    // getMaxCompressedFrameBlockSize(source_size) bytes
+    void doCompressFrameBlocks(
+        std::span<FrameBlockTask> tasks,
+        FrameChecksum checksum = FrameChecksum::Both,
+        unsigned threads = 1) const;
+
+    UInt32 getMaxCompressedFrameBlockSize(UInt32 block_size) const;
+
+    // Block size of frames for the requested block_size, which must be a multiple of the float width
+    // up to MAX_FRAME_BLOCK_SIZE. 0 picks FRAME_BLOCK_SIZE, raised at high levels to the size of the predictor
+    // tables so clearing them stays cheap next to encoding the block.
+    UInt32 getFrameBlockSize(UInt32 block_size = 0) const;
+
+    static UInt64 getFrameUncompressedSize(const char* source, UInt64 source_size);
+
+    // Instruction set of the kernels picked for this host: scalar, sse4, avx2 or avx512.
+    // Resolved once from cpuid, the FPC_CODEC_ISA environment variable can lower it for testing.
+    static std::string_view getDispatchedIsa();
+
     static constexpr UInt32 HEADER_SIZE{3};
+    // Header of streams encoded from a PredictorSnapshot, it carries the snapshot id
+    static constexpr UInt32 MAX_HEADER_SIZE{HEADER_SIZE + sizeof(UInt32)};
+    static constexpr UInt32 FRAME_HEADER_SIZE{20};
+    static constexpr UInt32 FRAME_BLOCK_SIZE{1 << 20};
+    static constexpr UInt32 MAX_FRAME_BLOCK_SIZE{1 << 30};
+    // Predictor tables take 2 << level values, the largest ones 4 GiB
+    static constexpr UInt8 MAX_COMPRESSION_LEVEL{28};
 
 private:
+    template <typename Statistics>
+    UInt32 compressImpl(const char* source, UInt32 source_size, char* dest, Statistics& statistics) const;
+
+    // Block in one of BlockEncodings, flag is its header flag and exponent the one of decimal blocks.
+    // values are the source values when compressing and the payload after the header when decompressing
+    struct EncodedBlock {
+        UInt8 flag;
+        UInt8 exponent;
+        std::span<const std::byte> values;
+    };
+
+    // The first of block_encodings source qualifies for, nullopt when it is compressed as plain FPC
+    std::optional<EncodedBlock> chooseBlockEncoding(std::span<const std::byte> source) const;
+
+    template <typename Statistics>
+    UInt32 compressEncodedBlock(const EncodedBlock& block, char* dest, Statistics& statistics) const;
+
+    // Validates the header of an encoded block, nullopt when source is not one
+    std::optional<EncodedBlock> encodedBlock(const char* source, UInt32 source_size) const;
+
+    template <std::unsigned_integral TUint>
+    void appendImpl(std::span<const std::byte> source, std::span<std::byte> dest, AppendState& state) const;
+
+    template <std::unsigned_integral TUint>
+    void recoverImpl(std::span<const std::byte> source, std::size_t value_count, AppendState& state) const;
+
+    void writeHeader(char* dest) const;
+
+    UInt32 headerSize() const noexcept {
+        return predictor_snapshot == nullptr ? HEADER_SIZE : MAX_HEADER_SIZE;
+    }
+
+    // Saved predictor state to start streams from, empty without a snapshot
+    std::span<const std::byte> predictorState() const noexcept {
+        return predictor_snapshot == nullptr ? std::span<const std::byte>{} : std::span(predictor_snapshot->state);
+    }
+
+    // Validates the header of doCompressData output and returns the encoded values after it
+    std::span<const std::byte> compressedPayload(const char* source, UInt32 source_size) const;
+
     UInt8 float_width;
     UInt8 level;
+    std::pmr::memory_resource* memory_resource;
+    const PredictorSnapshot* predictor_snapshot{nullptr};
+    BlockEncodings block_encodings{BlockEncodings::None};
+};
+
+// Front end of CompressionCodecFPCInteger applied before the predictors. Differences are zigzag mapped,
+// so small negative steps keep their leading zero bytes
+enum class IntegerTransform : UInt8 {
+    None,
+    Delta,
+    DeltaOfDelta,
+};
+
+// FPC over 32 or 64-bit integer columns such as timestamps and counters. Values are transformed one chunk
+// at a time and encoded by the same predictors and residual coding as floats. The header has the float
+// header layout with the integer flag set in the endianness byte and the transform in a fourth byte,
+// so the codecs reject each other's streams. Sizes must hold whole values.
+class CompressionCodecFPCInteger {
+public:
+    CompressionCodecFPCInteger(
+        UInt8 integer_size,
+        UInt8 compression_level,
+        IntegerTransform integer_transform,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    UInt32 doCompressData(const char* source, UInt32 source_size, char* dest) const;
+
+    void doDecompressData(const char* source, UInt32 source_size, char* dest, UInt32 uncompressed_size) const;
+
+    UInt32 getMaxCompressedDataSize(UInt32 uncompressed_size) const;
+
+    static constexpr UInt32 HEADER_SIZE{4};
+
+private:
+    UInt8 integer_width;
+    UInt8 level;
+    IntegerTransform transform;
+    std::pmr::memory_resource* memory_resource;
 };
 
 
@@ -45,21 +713,94 @@ const int BAD_ARGUMENTS = 1;
 
 }
 
-UInt32 CompressionCodecFPC::getMaxCompressedDataSize(UInt32 uncompressed_size) const {
+namespace {
+
+UInt64 getMaxPayloadSize(UInt64 uncompressed_size, UInt8 float_width) {
     auto float_count = (uncompressed_size + float_width - 1) / float_width;
     if (float_count % 2 != 0) {
         ++float_count;
     }
-    return HEADER_SIZE + float_count * float_width + float_count / 2;
+    return float_count * float_width + float_count / 2;
+}
+
+}
+
+UInt32 CompressionCodecFPC::getMaxCompressedDataSize(UInt32 uncompressed_size) const {
+    // Decimal blocks store the exponent after the header
+    auto encoding_header_size = block_encodings & BlockEncodings::Decimal ? 1 : 0;
+    auto max_size = headerSize() + encoding_header_size + getMaxPayloadSize(uncompressed_size, float_width);
+    if (max_size > std::numeric_limits<UInt32>::max())
+        throw Exception("Cannot compress. Data is too large, use doCompressFrame", ErrorCodes::CANNOT_COMPRESS);
+    return static_cast<UInt32>(max_size);
+}
+
+// Encoded pairs take at most one byte more than the values they hold, so any suffix of the stream expands its values
+// by no more than the whole stream does. The read position stays ahead of the written chunks by that bound
+UInt32 CompressionCodecFPC::getInPlaceDecompressionMargin(UInt32 uncompressed_size) const {
+    return getMaxCompressedDataSize(uncompressed_size) - uncompressed_size;
+}
+
+UInt32 CompressionCodecFPC::getSelectionBitmapSize(UInt32 uncompressed_size) const {
+    auto values = uncompressed_size / float_width;
+    return (values + 63) / 64;
+}
+
+namespace {
+
+void checkCompressionLevel(UInt8 level) {
+    if (level == 0 || level > CompressionCodecFPC::MAX_COMPRESSION_LEVEL)
+        throw Exception("Incorrect compression level", ErrorCodes::ILLEGAL_CODEC_PARAMETER);
+}
+
+void checkCodecParameters(UInt8 float_width, UInt8 level) {
+    if (float_width != sizeof(Float64) && float_width != sizeof(Float32))
+        throw Exception("Incorrect float width", ErrorCodes::ILLEGAL_CODEC_PARAMETER);
+    checkCompressionLevel(level);
+}
+
+}
+
+CompressionCodecFPC::CompressionCodecFPC(
+    UInt8 float_size,
+    UInt8 compression_level,
+    std::pmr::memory_resource* resource)
+    : float_width{float_size}, level{compression_level}, memory_resource{resource}
+{
+    checkCodecParameters(float_width, level);
+}
+
+CompressionCodecFPC::CompressionCodecFPC(
+    UInt8 float_size,
+    UInt8 compression_level,
+    BlockEncodings encodings,
+    std::pmr::memory_resource* resource)
+    : float_width{float_size}, level{compression_level}, memory_resource{resource}, block_encodings{encodings}
+{
+    checkCodecParameters(float_width, level);
 }
 
-CompressionCodecFPC::CompressionCodecFPC(UInt8 float_size, UInt8 compression_level)
-    : float_width{float_size}, level{compression_level}
+CompressionCodecFPC::CompressionCodecFPC(const PredictorSnapshot& snapshot, std::pmr::memory_resource* resource)
+    : float_width{snapshot.float_width}, level{snapshot.level}, memory_resource{resource}, predictor_snapshot{&snapshot}
 {
+    checkCodecParameters(float_width, level);
 }
 
 namespace {
 
+// Set in the endianness byte of stream headers followed by the id of a PredictorSnapshot
+constexpr UInt8 SNAPSHOT_HEADER_FLAG{0x80};
+// Set in the endianness byte of CompressionCodecFPCInteger stream headers
+constexpr UInt8 INTEGER_HEADER_FLAG{0x40};
+// Set in the endianness byte of stream headers followed by the exponent of a decimal block
+constexpr UInt8 DECIMAL_HEADER_FLAG{0x20};
+// Set in the endianness byte of stream headers of Float64 blocks encoded as Float32
+constexpr UInt8 DOWNCAST_HEADER_FLAG{0x10};
+constexpr UInt8 BLOCK_ENCODING_HEADER_FLAGS{DECIMAL_HEADER_FLAG | DOWNCAST_HEADER_FLAG};
+
+constexpr UInt32 encodedBlockHeaderSize(UInt8 encoding_flag) noexcept {
+    return CompressionCodecFPC::HEADER_SIZE + (encoding_flag == DECIMAL_HEADER_FLAG ? 1 : 0);
+}
+
 UInt8 encodeEndianness(std::endian endian) {
     switch (endian) {
         case std::endian::little:
@@ -84,11 +825,159 @@ std::endian decodeEndianness(UInt8 endian) {
 
 namespace {
 
+class XxHash64 {
+    static constexpr UInt64 PRIME_1{0x9E3779B185EBCA87ull};
+    static constexpr UInt64 PRIME_2{0xC2B2AE3D27D4EB4Full};
+    static constexpr UInt64 PRIME_3{0x165667B19E3779F9ull};
+    static constexpr UInt64 PRIME_4{0x85EBCA77C2B2AE63ull};
+    static constexpr UInt64 PRIME_5{0x27D4EB2F165667C5ull};
+    static constexpr std::size_t STRIPE_SIZE{32};
+
+public:
+    explicit XxHash64(UInt64 hash_seed = 0) noexcept
+        : accumulators{hash_seed + PRIME_1 + PRIME_2, hash_seed + PRIME_2, hash_seed, hash_seed - PRIME_1}
+        , seed{hash_seed} {
+    }
+
+    void update(std::span<const std::byte> data) noexcept {
+        total_size += data.size();
+        if (buffered + data.size() < STRIPE_SIZE) {
+            std::memcpy(buffer.data() + buffered, data.data(), data.size());
+            buffered += data.size();
+            return;
+        }
+        if (buffered != 0) {
+            auto fill = STRIPE_SIZE - buffered;
+            std::memcpy(buffer.data() + buffered, data.data(), fill);
+            consumeStripes(buffer);
+            data = data.subspan(fill);
+            buffered = 0;
+        }
+        data = data.subspan(consumeStripes(data));
+        std::memcpy(buffer.data(), data.data(), data.size());
+        buffered = data.size();
+    }
+
+    [[nodiscard]]
+    UInt64 digest() const noexcept {
+        UInt64 hash;
+        if (total_size >= STRIPE_SIZE) {
+            hash = std::rotl(accumulators[0], 1) + std::rotl(accumulators[1], 7)
+                + std::rotl(accumulators[2], 12) + std::rotl(accumulators[3], 18);
+            for (auto accumulator : accumulators)
+                hash = (hash ^ round(0, accumulator)) * PRIME_1 + PRIME_4;
+        } else {
+            hash = seed + PRIME_5;
+        }
+        hash += total_size;
+
+        std::size_t i = 0;
+        for (; i + 8 <= buffered; i += 8)
+            hash = std::rotl(hash ^ round(0, readLittleEndian<UInt64>(buffer.data() + i)), 27) * PRIME_1 + PRIME_4;
+        if (i + 4 <= buffered) {
+            hash = std::rotl(hash ^ (readLittleEndian<UInt32>(buffer.data() + i) * PRIME_1), 23) * PRIME_2 + PRIME_3;
+            i += 4;
+        }
+        for (; i < buffered; ++i)
+            hash = std::rotl(hash ^ (static_cast<UInt64>(buffer[i]) * PRIME_5), 11) * PRIME_1;
+
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        hash *= PRIME_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    template <std::unsigned_integral TUint>
+    static TUint readLittleEndian(const std::byte* data) noexcept {
+        TUint value;
+        std::memcpy(&value, data, sizeof(value));
+        if constexpr (std::endian::native == std::endian::big) {
+            if constexpr (sizeof(TUint) == sizeof(UInt64))
+                value = __builtin_bswap64(value);
+            else
+                value = __builtin_bswap32(value);
+        }
+        return value;
+    }
+
+    static UInt64 round(UInt64 accumulator, UInt64 input) noexcept {
+        return std::rotl(accumulator + input * PRIME_2, 31) * PRIME_1;
+    }
+
+    // Accumulators are kept in locals, the input is std::byte and would otherwise alias them
+    std::size_t consumeStripes(std::span<const std::byte> data) noexcept {
+        auto [acc1, acc2, acc3, acc4] = accumulators;
+        std::size_t i = 0;
+        for (; i + STRIPE_SIZE <= data.size(); i += STRIPE_SIZE) {
+            acc1 = round(acc1, readLittleEndian<UInt64>(data.data() + i));
+            acc2 = round(acc2, readLittleEndian<UInt64>(data.data() + i + 8));
+            acc3 = round(acc3, readLittleEndian<UInt64>(data.data() + i + 16));
+            acc4 = round(acc4, readLittleEndian<UInt64>(data.data() + i + 24));
+        }
+        accumulators = {acc1, acc2, acc3, acc4};
+        return i;
+    }
+
+    std::array<UInt64, 4> accumulators;
+    UInt64 seed;
+    UInt64 total_size{0};
+    std::array<std::byte, STRIPE_SIZE> buffer{};
+    std::size_t buffered{0};
+};
+
+// Checksum policy which is compiled out, used by default
+struct NoChecksum {
+    void update(std::span<const std::byte> /*uncompressed*/, std::span<const std::byte> /*compressed*/) noexcept {}
+};
+
+// Hashes the chunks while they are still in cache, right after they are encoded or decoded
+class BlockChecksum {
+public:
+    explicit BlockChecksum(FrameChecksum frame_checksum) noexcept
+        : checksum{frame_checksum} {
+    }
+
+    void update(std::span<const std::byte> uncompressed, std::span<const std::byte> compressed) noexcept {
+        if (hasCompressed())
+            compressed_hash.update(compressed);
+        if (hasUncompressed())
+            uncompressed_hash.update(uncompressed);
+    }
+
+    [[nodiscard]]
+    bool hasCompressed() const noexcept {
+        return (static_cast<UInt8>(checksum) & static_cast<UInt8>(FrameChecksum::Compressed)) != 0;
+    }
+
+    [[nodiscard]]
+    bool hasUncompressed() const noexcept {
+        return (static_cast<UInt8>(checksum) & static_cast<UInt8>(FrameChecksum::Uncompressed)) != 0;
+    }
+
+    [[nodiscard]]
+    UInt64 compressedDigest() const noexcept {
+        return compressed_hash.digest();
+    }
+
+    [[nodiscard]]
+    UInt64 uncompressedDigest() const noexcept {
+        return uncompressed_hash.digest();
+    }
+
+private:
+    FrameChecksum checksum;
+    XxHash64 compressed_hash;
+    XxHash64 uncompressed_hash;
+};
+
 template <std::unsigned_integral TUint> requires (sizeof(TUint) >= 4)
 class DfcmPredictor {
 public:
-    explicit DfcmPredictor(std::size_t table_size)
-        : table(table_size, 0)
+    DfcmPredictor(std::size_t table_size, std::pmr::memory_resource* resource)
+        : table(table_size, 0, resource)
         , prev_value{0}
         , hash{0} {
     }
@@ -100,21 +989,52 @@ public:
 
     void add(TUint value) noexcept {
         table[hash] = value - prev_value;
-        recalculateHash();
+        hash = nextHash(hash, table[hash], table.size() - 1);
         prev_value = value;
     }
 
-private:
-    void recalculateHash() noexcept {
-        auto value = table[hash];
+    void reset() noexcept {
+        std::fill(table.begin(), table.end(), 0);
+        prev_value = 0;
+        hash = 0;
+    }
+
+    // State is the hash, the previous value and the table in native byte order
+    static std::size_t stateSize(std::size_t table_size) noexcept {
+        return sizeof(UInt64) + sizeof(TUint) + table_size * sizeof(TUint);
+    }
+
+    // Returns the position past the written state
+    std::byte* saveState(std::byte* state) const noexcept {
+        auto saved_hash = static_cast<UInt64>(hash);
+        std::memcpy(state, &saved_hash, sizeof(saved_hash));
+        std::memcpy(state + sizeof(saved_hash), &prev_value, sizeof(prev_value));
+        std::memcpy(state + sizeof(saved_hash) + sizeof(prev_value), table.data(), table.size() * sizeof(TUint));
+        return state + stateSize(table.size());
+    }
+
+    // Returns the position past the read state
+    const std::byte* loadState(const std::byte* state) noexcept {
+        UInt64 saved_hash{0};
+        std::memcpy(&saved_hash, state, sizeof(saved_hash));
+        hash = static_cast<std::size_t>(saved_hash) & (table.size() - 1);
+        std::memcpy(&prev_value, state + sizeof(saved_hash), sizeof(prev_value));
+        std::memcpy(table.data(), state + sizeof(saved_hash) + sizeof(prev_value), table.size() * sizeof(TUint));
+        return state + stateSize(table.size());
+    }
+
+    // value is the difference just stored at hash, mask is the table size minus one
+    static std::size_t nextHash(std::size_t hash, TUint value, std::size_t mask) noexcept {
         if constexpr (sizeof(TUint) >= 8) {
-            hash = ((hash << 2) ^ static_cast<std::size_t>(value >> 40)) & (table.size() - 1);
+            return ((hash << 2) ^ static_cast<std::size_t>(value >> 40)) & mask;
         } else {
-            hash = ((hash << 4) ^ static_cast<std::size_t>(value >> 23)) & (table.size() - 1);
+            return ((hash << 4) ^ static_cast<std::size_t>(value >> 23)) & mask;
         }
     }
 
-    std::vector<TUint> table;
+private:
+
+    std::pmr::vector<TUint> table;
     TUint prev_value{0};
     std::size_t hash{0};
 };
@@ -122,8 +1042,8 @@ private:
 template <std::unsigned_integral TUint> requires (sizeof(TUint) >= 4)
 class FcmPredictor {
 public:
-    explicit FcmPredictor(std::size_t table_size)
-        : table(table_size, 0)
+    FcmPredictor(std::size_t table_size, std::pmr::memory_resource* resource)
+        : table(table_size, 0, resource)
         , hash{0} {
     }
 
@@ -134,63 +1054,235 @@ public:
 
     void add(TUint value) noexcept {
         table[hash] = value;
-        recalculateHash();
+        hash = nextHash(hash, value, table.size() - 1);
     }
 
-private:
-    void recalculateHash() noexcept {
-        auto value = table[hash];
-        if constexpr (sizeof(TUint) >= 8) {
-            hash = ((hash << 6) ^ static_cast<std::size_t>(value >> 48)) & (table.size() - 1);
-        } else {
-            hash = ((hash << 1) ^ static_cast<std::size_t>(value >> 22)) & (table.size() - 1);
-        }
+    void reset() noexcept {
+        std::fill(table.begin(), table.end(), 0);
+        hash = 0;
     }
 
-    std::vector<TUint> table;
-    std::size_t hash{0};
-};
+    // State is the hash and the table in native byte order
+    static std::size_t stateSize(std::size_t table_size) noexcept {
+        return sizeof(UInt64) + table_size * sizeof(TUint);
+    }
+
+    // Returns the position past the written state
+    std::byte* saveState(std::byte* state) const noexcept {
+        auto saved_hash = static_cast<UInt64>(hash);
+        std::memcpy(state, &saved_hash, sizeof(saved_hash));
+        std::memcpy(state + sizeof(saved_hash), table.data(), table.size() * sizeof(TUint));
+        return state + stateSize(table.size());
+    }
+
+    // Returns the position past the read state
+    const std::byte* loadState(const std::byte* state) noexcept {
+        UInt64 saved_hash{0};
+        std::memcpy(&saved_hash, state, sizeof(saved_hash));
+        hash = static_cast<std::size_t>(saved_hash) & (table.size() - 1);
+        std::memcpy(table.data(), state + sizeof(saved_hash), table.size() * sizeof(TUint));
+        return state + stateSize(table.size());
+    }
+
+    // value is the one just stored at hash, mask is the table size minus one
+    static std::size_t nextHash(std::size_t hash, TUint value, std::size_t mask) noexcept {
+        if constexpr (sizeof(TUint) >= 8) {
+            return ((hash << 6) ^ static_cast<std::size_t>(value >> 48)) & mask;
+        } else {
+            return ((hash << 1) ^ static_cast<std::size_t>(value >> 22)) & mask;
+        }
+    }
+
+private:
+
+    std::pmr::vector<TUint> table;
+    std::size_t hash{0};
+};
+
+template <std::unsigned_integral TUint, std::size_t Lanes>
+class BatchDecoder;
 
-template <std::unsigned_integral TUint, std::endian Endian = std::endian::native> requires (
-    Endian == std::endian::little || Endian == std::endian::big)
+template <
+    std::unsigned_integral TUint,
+    std::endian Endian = std::endian::native,
+    std::size_t ChunkSize = 64,
+    typename Statistics = NoEncoderStatistics,
+    typename Checksum = NoChecksum> requires (
+    (Endian == std::endian::little || Endian == std::endian::big) && ChunkSize > 0 && ChunkSize % 2 == 0)
 class FPCOperation {
-    static constexpr std::size_t CHUNK_SIZE{64};
+    // Decodes the same pair format for several streams at once
+    template <std::unsigned_integral, std::size_t>
+    friend class BatchDecoder;
 
+public:
+    static constexpr std::size_t CHUNK_SIZE{ChunkSize};
+
+private:
     static constexpr auto VALUE_SIZE = sizeof(TUint);
     static constexpr std::byte DFCM_BIT_1{1u << 7};
     static constexpr std::byte DFCM_BIT_2{1u << 3};
     static constexpr unsigned MAX_COMPRESSED_SIZE{0b111u};
 
 public:
-    explicit FPCOperation(std::span<std::byte> destination, UInt8 compression_level)
-        : dfcm_predictor(1 << compression_level)
-        , fcm_predictor(1 << compression_level)
+    FPCOperation(
+        std::span<std::byte> destination,
+        UInt8 compression_level,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        Checksum chunk_checksum = {})
+        : dfcm_predictor(1 << compression_level, resource)
+        , fcm_predictor(1 << compression_level, resource)
         , chunk{}
-        , result{destination} {
+        , result{destination}
+        , checksum{chunk_checksum} {
+    }
+
+    // Starts from predictor_state written by saveState instead of empty tables, empty state is ignored
+    FPCOperation(
+        std::span<std::byte> destination,
+        UInt8 compression_level,
+        std::pmr::memory_resource* resource,
+        std::span<const std::byte> predictor_state)
+        : FPCOperation(destination, compression_level, resource) {
+        if (!predictor_state.empty())
+            fcm_predictor.loadState(dfcm_predictor.loadState(predictor_state.data()));
+    }
+
+    static std::size_t stateSize(UInt8 compression_level) noexcept {
+        return DfcmPredictor<TUint>::stateSize(std::size_t{1} << compression_level)
+            + FcmPredictor<TUint>::stateSize(std::size_t{1} << compression_level);
+    }
+
+    void saveState(std::span<std::byte> predictor_state) const noexcept {
+        fcm_predictor.saveState(dfcm_predictor.saveState(predictor_state.data()));
+    }
+
+    // Starts a new stream into destination from empty tables without reallocating them,
+    // the operation may be reused this way after encode or decode
+    void reset(std::span<std::byte> destination, Checksum chunk_checksum = {}) noexcept {
+        dfcm_predictor.reset();
+        fcm_predictor.reset();
+        result = destination;
+        encoder_statistics = {};
+        checksum = chunk_checksum;
     }
 
     std::size_t encode(std::span<const std::byte> data)&& {
+        return encodeMore(data);
+    }
+
+    // Same as encode, but the stream may be continued by further calls. All calls but the last one
+    // must pass whole pairs of values
+    std::size_t encodeMore(std::span<const std::byte> data) {
         auto initial_size = result.size();
 
         std::span chunk_view(chunk);
         for (std::size_t i = 0; i < data.size(); i += chunk_view.size_bytes()) {
             auto written_values = importChunk(data.subspan(i), chunk_view);
+            auto chunk_result = result;
             encodeChunk(chunk_view.subspan(0, written_values));
+            checksum.update(
+                data.subspan(i, std::min(chunk_view.size_bytes(), data.size() - i)),
+                chunk_result.first(chunk_result.size() - result.size()));
         }
 
         return initial_size - result.size();
     }
 
-    void decode(std::span<const std::byte> values, std::size_t decoded_size)&& {
-        std::size_t read_bytes{0};
+    // Encodes count values read from base + i * stride, output is the same as encode of the gathered values
+    std::size_t encodeStrided(const std::byte* base, std::size_t stride, std::size_t count)&& {
+        auto initial_size = result.size();
 
-        std::span<TUint> chunk_view(chunk);
-        for (std::size_t i = 0; i < decoded_size; i += chunk_view.size_bytes()) {
-            if (i + chunk_view.size_bytes() > decoded_size)
-                chunk_view = chunk_view.first(ceilBytesToEvenValues(decoded_size - i));
-            read_bytes += decodeChunk(values.subspan(read_bytes), chunk_view);
-            exportChunk(chunk_view);
+        std::span chunk_view(chunk);
+        for (std::size_t i = 0; i < count; i += CHUNK_SIZE) {
+            auto written_values = importChunk(base + i * stride, stride, std::min(CHUNK_SIZE, count - i), chunk_view);
+            encodeChunk(chunk_view.subspan(0, written_values));
+        }
+
+        return initial_size - result.size();
+    }
+
+    // Returns the number of bytes encode would emit for data, only predictors state is updated
+    std::size_t measure(std::span<const std::byte> data) {
+        std::size_t bytes{0};
+
+        std::span chunk_view(chunk);
+        for (std::size_t i = 0; i < data.size(); i += chunk_view.size_bytes()) {
+            auto written_values = importChunk(data.subspan(i), chunk_view);
+            for (auto value : chunk_view.first(written_values))
+                bytes += VALUE_SIZE - decodeCompressedSize(compressValue(value).compressed_size);
+            bytes += written_values / 2;
+        }
+        return bytes;
+    }
+
+    [[nodiscard]]
+    const Statistics& statistics() const noexcept {
+        return encoder_statistics;
+    }
+
+    [[nodiscard]]
+    const Checksum& chunkChecksum() const noexcept {
+        return checksum;
+    }
+
+    // Returns the number of consumed bytes of values
+    std::size_t decode(std::span<const std::byte> values, std::size_t decoded_size)&& {
+        return decodeChunks(values, decoded_size, [this](std::span<const TUint> chnk, std::size_t) {
+            exportChunk(chnk);
+        });
+    }
+
+    // Same as above, but the destination is not written: consumer is called with every decoded chunk
+    // trimmed to the whole values of decoded_size
+    template <typename Consumer>
+    std::size_t decode(std::span<const std::byte> values, std::size_t decoded_size, Consumer&& consumer)&& {
+        return decodeChunks(values, decoded_size, [&consumer](std::span<const TUint> chnk, std::size_t chunk_bytes) {
+            consumer(chnk.first(chunk_bytes / VALUE_SIZE));
+        });
+    }
+
+    // Decodes count values to base + i * stride, returns the number of consumed bytes of values
+    std::size_t decodeStrided(
+        std::span<const std::byte> values, std::byte* base, std::size_t stride, std::size_t count)&& {
+        auto on_chunk = [&base, stride](std::span<const TUint> chnk, std::size_t chunk_bytes) {
+            base = exportChunk(chnk.first(chunk_bytes / VALUE_SIZE), base, stride);
+        };
+        return decodeChunks(values, count * VALUE_SIZE, on_chunk);
+    }
+
+    // Stepwise decoding for lazy consumers: decodes the next count <= CHUNK_SIZE values from the front of values
+    // and drops the consumed bytes from it. The result views the internal chunk and is valid until the next step
+    std::span<const TUint> decodeStep(std::span<const std::byte>& values, std::size_t count) {
+        auto chunk_view = std::span(chunk).first(count + count % 2);
+        values = values.subspan(decodeChunk(values, chunk_view));
+        return std::span<const TUint>(chunk_view).first(count);
+    }
+
+    // Decodes at most max_values values, stopping at the end of values on a pair boundary.
+    // Returns the number of decoded values, no bytes past the pairs holding them are read
+    std::size_t decodePrefix(std::span<const std::byte> values, std::size_t max_values)&& {
+        return std::move(*this).decodePrefix(values, max_values, [this](std::span<const TUint> chnk) {
+            exportChunk(chnk);
+        });
+    }
+
+    // Same as above, but the destination is not written: consumer is called with every decoded chunk
+    template <typename Consumer>
+    std::size_t decodePrefix(std::span<const std::byte> values, std::size_t max_values, Consumer&& consumer)&& {
+        std::size_t read_bytes{0};
+        std::size_t decoded_values{0};
+        while (decoded_values < max_values && read_bytes < values.size()) {
+            auto wanted = std::min(CHUNK_SIZE, max_values - decoded_values);
+            auto chunk_view = std::span(chunk).first(wanted + wanted % 2);
+            auto [chunk_read_bytes, chunk_values] = decodeAvailable(values.subspan(read_bytes), chunk_view);
+            auto exported = std::min(wanted, chunk_values);
+            consumer(std::span<const TUint>(chunk_view).first(exported));
+            read_bytes += chunk_read_bytes;
+            decoded_values += exported;
+            if (chunk_values < chunk_view.size())
+                break;
         }
+        return decoded_values;
     }
 
 private:
@@ -199,6 +1291,26 @@ private:
         return values_count % 2 == 0 ? values_count : values_count + 1;
     }
 
+    template <typename Func>
+    std::size_t decodeChunks(std::span<const std::byte> values, std::size_t decoded_size, Func&& on_chunk) {
+        std::size_t read_bytes{0};
+
+        std::span<TUint> chunk_view(chunk);
+        for (std::size_t i = 0; i < decoded_size; i += chunk_view.size_bytes()) {
+            if (i + chunk_view.size_bytes() > decoded_size)
+                chunk_view = chunk_view.first(ceilBytesToEvenValues(decoded_size - i));
+            auto chunk_read_bytes = decodeChunk(values.subspan(read_bytes), chunk_view);
+            auto chunk_bytes = std::min(chunk_view.size_bytes(), decoded_size - i);
+            // The encoded bytes are hashed first, in-place decoding may overwrite them by the chunk
+            checksum.update(
+                std::as_bytes(chunk_view).first(chunk_bytes),
+                values.subspan(read_bytes, chunk_read_bytes));
+            on_chunk(std::span<const TUint>(chunk_view), chunk_bytes);
+            read_bytes += chunk_read_bytes;
+        }
+        return read_bytes;
+    }
+
     std::size_t importChunk(std::span<const std::byte> values, std::span<TUint> chnk) {
         if (auto chunk_view = std::as_writable_bytes(chnk); chunk_view.size() <= values.size()) {
             std::memcpy(chunk_view.data(), values.data(), chunk_view.size());
@@ -210,6 +1322,23 @@ private:
         }
     }
 
+    std::size_t importChunk(const std::byte* base, std::size_t stride, std::size_t count, std::span<TUint> chnk) {
+        for (std::size_t i = 0; i < count; ++i)
+            std::memcpy(&chnk[i], base + i * stride, VALUE_SIZE);
+        if (count % 2 != 0)
+            chnk[count++] = 0;
+        return count;
+    }
+
+    // Returns the position of the value following the chunk
+    static std::byte* exportChunk(std::span<const TUint> chnk, std::byte* base, std::size_t stride) {
+        for (auto value : chnk) {
+            std::memcpy(base, &value, VALUE_SIZE);
+            base += stride;
+        }
+        return base;
+    }
+
     void exportChunk(std::span<const TUint> chnk) {
         auto chunk_view = std::as_bytes(chnk).first(std::min(result.size(), chnk.size_bytes()));
         std::memcpy(result.data(), chunk_view.data(), chunk_view.size());
@@ -236,7 +1365,7 @@ private:
         return std::min(static_cast<unsigned>(compressed), MAX_COMPRESSED_SIZE);
     }
 
-    unsigned decodeCompressedSize(unsigned encoded_size) {
+    static unsigned decodeCompressedSize(unsigned encoded_size) {
         if constexpr (VALUE_SIZE > MAX_COMPRESSED_SIZE) {
             if (encoded_size > 3)
                 ++encoded_size;
@@ -266,23 +1395,51 @@ private:
             header |= DFCM_BIT_2;
         header |= static_cast<std::byte>((compressed_size1 << 4) | compressed_size2);
         result.front() = header;
+        encoder_statistics.addValue(is_dfcm_predictor1, compressed_size1);
+        encoder_statistics.addValue(is_dfcm_predictor2, compressed_size2);
 
         compressed_size1 = decodeCompressedSize(compressed_size1);
         compressed_size2 = decodeCompressedSize(compressed_size2);
         auto tail_size1 = VALUE_SIZE - compressed_size1;
         auto tail_size2 = VALUE_SIZE - compressed_size2;
+        encoder_statistics.addBytes(1 + tail_size1 + tail_size2);
 
         std::memcpy(result.data() + 1, valueTail(value1, compressed_size1), tail_size1);
         std::memcpy(result.data() + 1 + tail_size1, valueTail(value2, compressed_size2), tail_size2);
         result = result.subspan(1 + tail_size1 + tail_size2);
     }
 
+    // Worst case of an encoded pair: header byte and both values stored in full
+    static constexpr std::size_t MAX_PAIR_SIZE{1 + 2 * VALUE_SIZE};
+
     std::size_t decodeChunk(std::span<const std::byte> values, std::span<TUint> seq) {
+        auto [read_bytes, decoded_values] = decodeAvailable(values, seq);
+        if (decoded_values < seq.size())
+            throw Exception(ErrorCodes::CANNOT_DECOMPRESS, "Unexpected end of encoded sequence");
+        return read_bytes;
+    }
+
+    // Decodes pairs of seq until values end, returns the numbers of consumed bytes and decoded values
+    std::pair<std::size_t, std::size_t> decodeAvailable(std::span<const std::byte> values, std::span<TUint> seq) {
+        // Bounds are checked once when the rest of the input can hold the whole chunk even uncompressed,
+        // only the last chunks of a buffer are decoded pair by pair with checks
+        if (values.size() >= seq.size() / 2 * MAX_PAIR_SIZE) {
+            const auto* position = values.data();
+            for (std::size_t i = 0; i < seq.size(); i += 2) {
+                position += decodePair(position, seq[i], seq[i + 1]);
+            }
+            return {static_cast<std::size_t>(position - values.data()), seq.size()};
+        }
+
         std::size_t read_bytes{0};
-        for (std::size_t i = 0; i < seq.size(); i += 2) {
-            read_bytes += decodePair(values.subspan(read_bytes), seq[i], seq[i + 1]);
+        std::size_t i = 0;
+        for (; i < seq.size() && read_bytes < values.size(); i += 2) {
+            auto bytes = values.subspan(read_bytes);
+            if (bytes.size() < pairSize(bytes.front()))
+                throw Exception(ErrorCodes::CANNOT_DECOMPRESS, "Unexpected end of encoded sequence");
+            read_bytes += decodePair(bytes.data(), seq[i], seq[i + 1]);
         }
-        return read_bytes;
+        return {read_bytes, i};
     }
 
     TUint decompressValue(TUint value, bool isDfcmPredictor) {
@@ -297,27 +1454,38 @@ private:
         return decompressed;
     }
 
-    std::size_t decodePair(std::span<const std::byte> bytes, TUint& first, TUint& second) {
-        if (bytes.empty())
-            throw Exception(ErrorCodes::CANNOT_DECOMPRESS, "Unexpected end of encoded sequence");
+    static std::pair<unsigned, unsigned> decodeCompressedSizes(std::byte header) {
+        auto compressed_size1 = decodeCompressedSize(static_cast<unsigned>(header >> 4) & MAX_COMPRESSED_SIZE);
+        auto compressed_size2 = decodeCompressedSize(static_cast<unsigned>(header) & MAX_COMPRESSED_SIZE);
+        // Only narrow values can be given a size larger than the value itself by a malformed header
+        if constexpr (VALUE_SIZE < MAX_COMPRESSED_SIZE) {
+            if (compressed_size1 > VALUE_SIZE || compressed_size2 > VALUE_SIZE)
+                throw Exception(ErrorCodes::CANNOT_DECOMPRESS, "Invalid compressed size");
+        }
+        return {compressed_size1, compressed_size2};
+    }
+
+    static std::size_t pairSize(std::byte header) {
+        auto [compressed_size1, compressed_size2] = decodeCompressedSizes(header);
+        return 1 + (VALUE_SIZE - compressed_size1) + (VALUE_SIZE - compressed_size2);
+    }
 
-        auto compressed_size1 = decodeCompressedSize(static_cast<unsigned>(bytes.front() >> 4) & MAX_COMPRESSED_SIZE);
-        auto compressed_size2 = decodeCompressedSize(static_cast<unsigned>(bytes.front()) & MAX_COMPRESSED_SIZE);
+    // Caller guarantees that bytes holds the whole pair
+    std::size_t decodePair(const std::byte* bytes, TUint& first, TUint& second) {
+        auto header = *bytes;
+        auto [compressed_size1, compressed_size2] = decodeCompressedSizes(header);
 
         auto tail_size1 = VALUE_SIZE - compressed_size1;
         auto tail_size2 = VALUE_SIZE - compressed_size2;
 
-        if (bytes.size() < 1 + tail_size1 + tail_size2)
-            throw Exception(ErrorCodes::CANNOT_DECOMPRESS, "Unexpected end of encoded sequence");
-
         TUint value1{0};
         TUint value2{0};
 
-        std::memcpy(valueTail(value1, compressed_size1), bytes.data() + 1, tail_size1);
-        std::memcpy(valueTail(value2, compressed_size2), bytes.data() + 1 + tail_size1, tail_size2);
+        std::memcpy(valueTail(value1, compressed_size1), bytes + 1, tail_size1);
+        std::memcpy(valueTail(value2, compressed_size2), bytes + 1 + tail_size1, tail_size2);
 
-        auto is_dfcm_predictor1 = static_cast<unsigned char>(bytes.front() & DFCM_BIT_1);
-        auto is_dfcm_predictor2 = static_cast<unsigned char>(bytes.front() & DFCM_BIT_2);
+        auto is_dfcm_predictor1 = static_cast<unsigned char>(header & DFCM_BIT_1);
+        auto is_dfcm_predictor2 = static_cast<unsigned char>(header & DFCM_BIT_2);
         first = decompressValue(value1, is_dfcm_predictor1 != 0);
         second = decompressValue(value2, is_dfcm_predictor2 != 0);
 
@@ -336,55 +1504,2213 @@ private:
     FcmPredictor<TUint> fcm_predictor;
     std::array<TUint, CHUNK_SIZE> chunk{};
     std::span<std::byte> result{};
+    [[no_unique_address]] Statistics encoder_statistics{};
+    [[no_unique_address]] Checksum checksum;
+};
+
+// Input and output of one stream of a batch, source excludes the stream header
+struct BatchStream {
+    std::span<const std::byte> source;
+    std::span<std::byte> dest;
+};
+
+// Decodes up to Lanes independent streams in lockstep, one stream per lane. Every stream is serial through
+// its predictor hash chain, but the chains of different lanes are independent: predictor state is kept as
+// structure of arrays, so the table lookups of all lanes overlap in the pipeline or become gathers.
+template <std::unsigned_integral TUint, std::size_t Lanes>
+class BatchDecoder {
+    using Format = FPCOperation<TUint>;
+    static constexpr auto VALUE_SIZE = sizeof(TUint);
+    static constexpr std::size_t CHUNK_SIZE{Format::CHUNK_SIZE};
+
+public:
+    BatchDecoder(UInt8 compression_level, std::pmr::memory_resource* resource)
+        : table_size{std::size_t{1} << compression_level}
+        , dfcm_table(table_size * Lanes, 0, resource)
+        , fcm_table(table_size * Lanes, 0, resource) {
+    }
+
+    // Decodes at most Lanes streams, each as FPCOperation::decode would
+    void decode(std::span<const BatchStream> streams) {
+        std::fill(dfcm_table.begin(), dfcm_table.end(), 0);
+        std::fill(fcm_table.begin(), fcm_table.end(), 0);
+
+        // Lane state lives in locals, which table stores cannot alias
+        LaneState state{};
+        for (std::size_t lane = 0; lane < streams.size(); ++lane) {
+            state.positions[lane] = streams[lane].source.data();
+            state.ends[lane] = streams[lane].source.data() + streams[lane].source.size();
+            state.destinations[lane] = streams[lane].dest;
+        }
+
+        // Whole chunks of all lanes are decoded together while every lane has one left,
+        // the bounds of a chunk are checked once as in FPCOperation
+        if (streams.size() == Lanes) {
+            while (lockstepAvailable(state))
+                decodeLockstep(state);
+        }
+
+        // Tails differ in length, they are finished lane by lane with checks on every pair
+        for (std::size_t lane = 0; lane < streams.size(); ++lane) {
+            auto& destination = state.destinations[lane];
+            while (!destination.empty()) {
+                auto values = std::min(CHUNK_SIZE, (destination.size() + VALUE_SIZE - 1) / VALUE_SIZE);
+                values += values % 2;
+                for (std::size_t i = 0; i < values; i += 2) {
+                    auto available = static_cast<std::size_t>(state.ends[lane] - state.positions[lane]);
+                    if (available == 0 || available < Format::pairSize(*state.positions[lane]))
+                        throw Exception(ErrorCodes::CANNOT_DECOMPRESS, "Unexpected end of encoded sequence");
+                    std::byte header{};
+                    TUint residual1{0};
+                    TUint residual2{0};
+                    state.positions[lane] += readPair(state.positions[lane], header, residual1, residual2);
+                    state.chunks[lane][i] = decodeValue(state, lane, residual1, header & Format::DFCM_BIT_1);
+                    state.chunks[lane][i + 1] = decodeValue(state, lane, residual2, header & Format::DFCM_BIT_2);
+                }
+                exportChunk(state, lane, values);
+            }
+        }
+    }
+
+private:
+    struct LaneState {
+        std::array<std::size_t, Lanes> dfcm_hashes;
+        std::array<std::size_t, Lanes> fcm_hashes;
+        std::array<TUint, Lanes> prev_values;
+        std::array<const std::byte*, Lanes> positions;
+        std::array<const std::byte*, Lanes> ends;
+        std::array<std::span<std::byte>, Lanes> destinations;
+        std::array<std::array<TUint, CHUNK_SIZE>, Lanes> chunks;
+    };
+
+    static bool lockstepAvailable(const LaneState& state) noexcept {
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+            auto available = static_cast<std::size_t>(state.ends[lane] - state.positions[lane]);
+            if (state.destinations[lane].size() < CHUNK_SIZE * VALUE_SIZE
+                || available < CHUNK_SIZE / 2 * Format::MAX_PAIR_SIZE)
+                return false;
+        }
+        return true;
+    }
+
+    void decodeLockstep(LaneState& state) {
+        for (std::size_t i = 0; i < CHUNK_SIZE; i += 2) {
+            std::array<std::byte, Lanes> headers{};
+            std::array<TUint, Lanes> residuals1{};
+            std::array<TUint, Lanes> residuals2{};
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                state.positions[lane] += readPairWide(
+                    state.positions[lane], headers[lane], residuals1[lane], residuals2[lane]);
+            }
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+                state.chunks[lane][i] = decodeValue(state, lane, residuals1[lane], headers[lane] & Format::DFCM_BIT_1);
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+                state.chunks[lane][i + 1] = decodeValue(state, lane, residuals2[lane], headers[lane] & Format::DFCM_BIT_2);
+        }
+        for (std::size_t lane = 0; lane < Lanes; ++lane)
+            exportChunk(state, lane, CHUNK_SIZE);
+    }
+
+    // Caller guarantees that bytes holds the whole pair
+    static std::size_t readPair(const std::byte* bytes, std::byte& header, TUint& residual1, TUint& residual2) {
+        header = *bytes;
+        auto [compressed_size1, compressed_size2] = Format::decodeCompressedSizes(header);
+        auto tail_size1 = VALUE_SIZE - compressed_size1;
+        auto tail_size2 = VALUE_SIZE - compressed_size2;
+        std::memcpy(Format::valueTail(residual1, compressed_size1), bytes + 1, tail_size1);
+        std::memcpy(Format::valueTail(residual2, compressed_size2), bytes + 1 + tail_size1, tail_size2);
+        return 1 + tail_size1 + tail_size2;
+    }
+
+    // Same as readPair, but bytes must hold MAX_PAIR_SIZE bytes: tails are read as whole values and masked
+    static std::size_t readPairWide(const std::byte* bytes, std::byte& header, TUint& residual1, TUint& residual2) {
+        if constexpr (std::endian::native != std::endian::little) {
+            return readPair(bytes, header, residual1, residual2);
+        } else {
+            header = *bytes;
+            auto [compressed_size1, compressed_size2] = Format::decodeCompressedSizes(header);
+            auto tail_size1 = VALUE_SIZE - compressed_size1;
+            auto tail_size2 = VALUE_SIZE - compressed_size2;
+            std::memcpy(&residual1, bytes + 1, VALUE_SIZE);
+            std::memcpy(&residual2, bytes + 1 + tail_size1, VALUE_SIZE);
+            // Two shifts avoid shifting by the whole width when nothing is stored
+            residual1 &= (~TUint{0} >> (compressed_size1 * 4)) >> (compressed_size1 * 4);
+            residual2 &= (~TUint{0} >> (compressed_size2 * 4)) >> (compressed_size2 * 4);
+            return 1 + tail_size1 + tail_size2;
+        }
+    }
+
+    TUint decodeValue(LaneState& state, std::size_t lane, TUint residual, std::byte dfcm_bit) noexcept {
+        auto& dfcm_hash = state.dfcm_hashes[lane];
+        auto& fcm_hash = state.fcm_hashes[lane];
+        auto& prev_value = state.prev_values[lane];
+        auto* dfcm_slot = dfcm_table.data() + lane * table_size + dfcm_hash;
+        auto* fcm_slot = fcm_table.data() + lane * table_size + fcm_hash;
+
+        // Both tables are written below anyway, loading both keeps the selection branchless
+        auto dfcm_prediction = *dfcm_slot + prev_value;
+        auto fcm_prediction = *fcm_slot;
+        auto value = (dfcm_bit != std::byte{0} ? dfcm_prediction : fcm_prediction) ^ residual;
+        auto delta = value - prev_value;
+        *dfcm_slot = delta;
+        *fcm_slot = value;
+        dfcm_hash = DfcmPredictor<TUint>::nextHash(dfcm_hash, delta, table_size - 1);
+        fcm_hash = FcmPredictor<TUint>::nextHash(fcm_hash, value, table_size - 1);
+        prev_value = value;
+        return value;
+    }
+
+    static void exportChunk(LaneState& state, std::size_t lane, std::size_t values) {
+        auto& destination = state.destinations[lane];
+        auto size = std::min(destination.size(), values * VALUE_SIZE);
+        std::memcpy(destination.data(), state.chunks[lane].data(), size);
+        destination = destination.subspan(size);
+    }
+
+    std::size_t table_size;
+    std::pmr::vector<TUint> dfcm_table;
+    std::pmr::vector<TUint> fcm_table;
 };
 
+// Streams decoded together. Lanes are interleaved scalar decoders rather than vector lanes, 8 independent
+// predictor chains hide the latency of the table loads, more only spread the tables over more cache.
+constexpr std::size_t BATCH_LANES{8};
+// Interleaving pays off while the tables of all lanes fit in L2, otherwise every lane misses it
+constexpr std::size_t BATCH_TABLES_BUDGET{1 << 20};
+
+struct SampledSize {
+    double bytes_per_value;
+    double bytes_per_value_error;
+};
+
+// Inputs of at least MIN_SAMPLED_VALUES values are measured in SAMPLE_WINDOWS windows spread evenly over them,
+// each starts with values which only warm up predictor tables after the jump. Smaller inputs are measured whole
+constexpr std::size_t SAMPLE_WINDOWS{64};
+constexpr std::size_t SAMPLE_WARMUP_VALUES{256};
+constexpr std::size_t SAMPLE_VALUES{512};
+constexpr std::size_t MIN_SAMPLED_VALUES{4 * SAMPLE_WINDOWS * (SAMPLE_WARMUP_VALUES + SAMPLE_VALUES)};
+
+// Measures value_count values in sampled windows, run(first, count) returns the bytes of count values
+// starting at value first. Runs are requested in order and each is valid until the next request.
+// Predictor tables start from predictor_state the way streams of a snapshot do, empty state is ignored
+template <std::unsigned_integral TUint, typename Run>
+SampledSize sampleCompressedSize(
+    std::size_t value_count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state,
+    Run&& run) {
+    FPCOperation<TUint> operation({}, level, resource, predictor_state);
+    if (value_count < MIN_SAMPLED_VALUES) {
+        auto bytes = static_cast<double>(operation.measure(run(0, value_count)));
+        return {value_count == 0 ? 0.0 : bytes / static_cast<double>(value_count), 0.0};
+    }
+
+    auto stride = value_count / SAMPLE_WINDOWS;
+    double sum{0};
+    double sum_squares{0};
+    for (std::size_t window = 0; window < SAMPLE_WINDOWS; ++window) {
+        operation.measure(run(window * stride, SAMPLE_WARMUP_VALUES));
+        auto sample_bytes = operation.measure(run(window * stride + SAMPLE_WARMUP_VALUES, SAMPLE_VALUES));
+        auto bytes_per_value = static_cast<double>(sample_bytes) / SAMPLE_VALUES;
+        sum += bytes_per_value;
+        sum_squares += bytes_per_value * bytes_per_value;
+    }
+    auto mean = sum / SAMPLE_WINDOWS;
+    auto variance = std::max(0.0, (sum_squares - sum * mean) / (SAMPLE_WINDOWS - 1));
+    return {mean, 1.96 * std::sqrt(variance / SAMPLE_WINDOWS)};
 }
 
-UInt32 CompressionCodecFPC::doCompressData(const char* source, UInt32 source_size, char* dest) const {
-    dest[0] = static_cast<char>(float_width);
-    dest[1] = static_cast<char>(level);
-    dest[2] = static_cast<char>(encodeEndianness(std::endian::native));
+template <std::unsigned_integral TUint>
+SampledSize sampleCompressedSize(
+    std::span<const std::byte> data,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    auto run = [data](std::size_t first, std::size_t count) {
+        return data.subspan(first * sizeof(TUint), count * sizeof(TUint));
+    };
+    return sampleCompressedSize<TUint>(data.size() / sizeof(TUint), level, resource, predictor_state, run);
+}
 
-    auto destination = std::as_writable_bytes(std::span(dest, getMaxCompressedDataSize(source_size)).subspan(HEADER_SIZE));
-    auto src = std::as_bytes(std::span(source, source_size));
+}
+
+namespace {
+
+constexpr std::array<char, 4> SNAPSHOT_MAGIC{'F', 'P', 'C', 'S'};
+constexpr std::array<char, 4> APPEND_STATE_MAGIC{'F', 'P', 'C', 'A'};
+
+std::size_t predictorStateSize(UInt8 float_width, UInt8 level) {
+    if (level == 0 || level > CompressionCodecFPC::MAX_COMPRESSION_LEVEL)
+        throw Exception("Incorrect compression level of predictor state", ErrorCodes::ILLEGAL_CODEC_PARAMETER);
     switch (float_width) {
         case sizeof(Float64):
-            return HEADER_SIZE + FPCOperation<UInt64>(destination, level).encode(src);
+            return FPCOperation<UInt64>::stateSize(level);
         case sizeof(Float32):
-            return HEADER_SIZE + FPCOperation<UInt32>(destination, level).encode(src);
+            return FPCOperation<UInt32>::stateSize(level);
         default:
             break;
     }
-    throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+    throw Exception("Incorrect float width of predictor state", ErrorCodes::ILLEGAL_CODEC_PARAMETER);
 }
 
-void CompressionCodecFPC::doDecompressData(
+template <std::unsigned_integral TUint>
+void trainPredictors(
+    std::span<std::byte> state,
+    std::span<const std::byte> source,
+    UInt8 level,
+    std::pmr::memory_resource* resource) {
+    FPCOperation<TUint> operation({}, level, resource);
+    operation.measure(source);
+    operation.saveState(state);
+}
+
+}
+
+PredictorSnapshot::PredictorSnapshot(
+    UInt8 snapshot_float_width,
+    UInt8 snapshot_level,
+    UInt32 snapshot_id,
+    std::pmr::memory_resource* resource)
+    : float_width{snapshot_float_width}, level{snapshot_level}, id{snapshot_id}
+    , state(predictorStateSize(snapshot_float_width, snapshot_level), resource)
+{
+}
+
+PredictorSnapshot PredictorSnapshot::train(
+    UInt8 float_width,
+    UInt8 level,
+    UInt32 id,
     const char* source,
     UInt32 source_size,
-    char* dest,
-    UInt32 uncompressed_size) const {
-    if (source_size < HEADER_SIZE)
-        throw Exception("Cannot decompress. File has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+    std::pmr::memory_resource* resource) {
+    PredictorSnapshot snapshot(float_width, level, id, resource);
+    auto src = std::as_bytes(std::span(source, source_size));
+    if (float_width == sizeof(Float64))
+        trainPredictors<UInt64>(snapshot.state, src, level, resource);
+    else
+        trainPredictors<UInt32>(snapshot.state, src, level, resource);
+    return snapshot;
+}
 
-    auto compressed_data = std::span(source, source_size);
-    if (static_cast<UInt8>(compressed_data[0]) != float_width)
-        throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
-    if (static_cast<UInt8>(compressed_data[1]) != level)
-        throw Exception("Cannot decompress. File has incorrect compression level", ErrorCodes::CANNOT_DECOMPRESS);
-    if (decodeEndianness(static_cast<UInt8>(compressed_data[2])) != std::endian::native)
-        throw Exception("Cannot decompress. File has incorrect endianness", ErrorCodes::CANNOT_DECOMPRESS);
+std::size_t PredictorSnapshot::getSerializedSize() const noexcept {
+    return SERIALIZED_HEADER_SIZE + state.size();
+}
 
-    auto destination = std::as_writable_bytes(std::span(dest, uncompressed_size));
-    auto src = std::as_bytes(compressed_data.subspan(HEADER_SIZE));
+void PredictorSnapshot::serialize(char* dest) const {
+    std::memcpy(dest, SNAPSHOT_MAGIC.data(), SNAPSHOT_MAGIC.size());
+    dest[4] = static_cast<char>(float_width);
+    dest[5] = static_cast<char>(level);
+    dest[6] = static_cast<char>(encodeEndianness(std::endian::native));
+    dest[7] = 0;
+    std::memcpy(dest + 8, &id, sizeof(id));
+    std::memcpy(dest + SERIALIZED_HEADER_SIZE, state.data(), state.size());
+}
+
+PredictorSnapshot PredictorSnapshot::deserialize(
+    const char* source,
+    std::size_t source_size,
+    std::pmr::memory_resource* resource) {
+    if (source_size < SERIALIZED_HEADER_SIZE || std::memcmp(source, SNAPSHOT_MAGIC.data(), SNAPSHOT_MAGIC.size()) != 0)
+        throw Exception("Predictor snapshot has wrong header", ErrorCodes::BAD_ARGUMENTS);
+    if (decodeEndianness(static_cast<UInt8>(source[6])) != std::endian::native)
+        throw Exception("Predictor snapshot has incorrect endianness", ErrorCodes::BAD_ARGUMENTS);
+
+    // The size is checked before the state of the declared level is allocated
+    auto state_size = predictorStateSize(static_cast<UInt8>(source[4]), static_cast<UInt8>(source[5]));
+    if (source_size != SERIALIZED_HEADER_SIZE + state_size)
+        throw Exception("Predictor snapshot has wrong size", ErrorCodes::BAD_ARGUMENTS);
+    UInt32 id{0};
+    std::memcpy(&id, source + 8, sizeof(id));
+    PredictorSnapshot snapshot(static_cast<UInt8>(source[4]), static_cast<UInt8>(source[5]), id, resource);
+    std::memcpy(snapshot.state.data(), source + SERIALIZED_HEADER_SIZE, snapshot.state.size());
+    return snapshot;
+}
+
+AppendState::AppendState(UInt8 state_float_width, UInt8 state_level, std::pmr::memory_resource* resource)
+    : float_width{state_float_width}, level{state_level}
+    , predictor_state(predictorStateSize(state_float_width, state_level), resource)
+{
+}
+
+AppendState& AppendState::operator=(AppendState&& other) noexcept {
+    if (this == &other)
+        return *this;
+    float_width = other.float_width;
+    level = other.level;
+    has_pending = other.has_pending;
+    uncompressed_size = other.uncompressed_size;
+    compressed_size = other.compressed_size;
+    pairs_size = other.pairs_size;
+    pending_value = other.pending_value;
+    std::destroy_at(&predictor_state);
+    std::construct_at(&predictor_state, std::move(other.predictor_state));
+    return *this;
+}
+
+std::size_t AppendState::getSerializedSize() const noexcept {
+    return SERIALIZED_HEADER_SIZE + predictor_state.size();
+}
+
+void AppendState::serialize(char* dest) const {
+    std::memcpy(dest, APPEND_STATE_MAGIC.data(), APPEND_STATE_MAGIC.size());
+    dest[4] = static_cast<char>(float_width);
+    dest[5] = static_cast<char>(level);
+    dest[6] = static_cast<char>(encodeEndianness(std::endian::native));
+    dest[7] = static_cast<char>(has_pending);
+    std::memcpy(dest + 8, &uncompressed_size, sizeof(uncompressed_size));
+    std::memcpy(dest + 12, &compressed_size, sizeof(compressed_size));
+    std::memcpy(dest + 16, &pairs_size, sizeof(pairs_size));
+    std::memcpy(dest + 20, &pending_value, sizeof(pending_value));
+    std::memcpy(dest + SERIALIZED_HEADER_SIZE, predictor_state.data(), predictor_state.size());
+}
+
+AppendState AppendState::deserialize(
+    const char* source,
+    std::size_t source_size,
+    std::pmr::memory_resource* resource) {
+    if (source_size < SERIALIZED_HEADER_SIZE
+        || std::memcmp(source, APPEND_STATE_MAGIC.data(), APPEND_STATE_MAGIC.size()) != 0)
+        throw Exception("Append state has wrong header", ErrorCodes::BAD_ARGUMENTS);
+    if (decodeEndianness(static_cast<UInt8>(source[6])) != std::endian::native)
+        throw Exception("Append state has incorrect endianness", ErrorCodes::BAD_ARGUMENTS);
+
+    // The size is checked before the state of the declared level is allocated
+    auto state_size = predictorStateSize(static_cast<UInt8>(source[4]), static_cast<UInt8>(source[5]));
+    if (source_size != SERIALIZED_HEADER_SIZE + state_size || static_cast<UInt8>(source[7]) > 1)
+        throw Exception("Append state has wrong size", ErrorCodes::BAD_ARGUMENTS);
+    AppendState state(static_cast<UInt8>(source[4]), static_cast<UInt8>(source[5]), resource);
+    state.has_pending = source[7] != 0;
+    std::memcpy(&state.uncompressed_size, source + 8, sizeof(state.uncompressed_size));
+    std::memcpy(&state.compressed_size, source + 12, sizeof(state.compressed_size));
+    std::memcpy(&state.pairs_size, source + 16, sizeof(state.pairs_size));
+    std::memcpy(&state.pending_value, source + 20, sizeof(state.pending_value));
+    std::memcpy(state.predictor_state.data(), source + SERIALIZED_HEADER_SIZE, state.predictor_state.size());
+    if (state.pairs_size > state.compressed_size || state.uncompressed_size % state.float_width != 0
+        || state.has_pending != ((state.uncompressed_size / state.float_width) % 2 != 0))
+        throw Exception("Append state is inconsistent", ErrorCodes::BAD_ARGUMENTS);
+    return state;
+}
+
+UInt32 CompressionCodecFPC::doCompressData(const char* source, UInt32 source_size, char* dest, AppendState& state) const {
+    AppendState initial(float_width, level, memory_resource);
+    if (predictor_snapshot != nullptr)
+        initial.predictor_state.assign(predictor_snapshot->state.begin(), predictor_snapshot->state.end());
+    initial.compressed_size = headerSize();
+    initial.pairs_size = headerSize();
+
+    writeHeader(dest);
+    doAppendData(source, source_size, dest, initial);
+    state = std::move(initial);
+    return state.compressed_size;
+}
+
+UInt32 CompressionCodecFPC::doAppendData(const char* source, UInt32 source_size, char* dest, AppendState& state) const {
+    if (state.float_width != float_width || state.level != level)
+        throw Exception("Cannot compress. Append state belongs to another codec", ErrorCodes::BAD_ARGUMENTS);
+    if (source_size % float_width != 0)
+        throw Exception("Cannot compress. Appended data must hold whole values", ErrorCodes::BAD_ARGUMENTS);
+    auto total_size = static_cast<UInt64>(state.uncompressed_size) + source_size;
+    if (total_size > std::numeric_limits<UInt32>::max())
+        throw Exception("Cannot compress. Data is too large, use doCompressFrame", ErrorCodes::CANNOT_COMPRESS);
+
+    auto src = std::as_bytes(std::span(source, source_size));
+    auto destination = std::as_writable_bytes(std::span(dest, getMaxCompressedDataSize(static_cast<UInt32>(total_size))));
     switch (float_width) {
         case sizeof(Float64):
-            FPCOperation<UInt64>(destination, level).decode(src, uncompressed_size);
+            appendImpl<UInt64>(src, destination, state);
             break;
         case sizeof(Float32):
-            FPCOperation<UInt32>(destination, level).decode(src, uncompressed_size);
+            appendImpl<UInt32>(src, destination, state);
             break;
         default:
+            throw Exception("Cannot compress. Incorrect float width", ErrorCodes::CANNOT_COMPRESS);
+    }
+    return state.compressed_size;
+}
+
+template <std::unsigned_integral TUint>
+void CompressionCodecFPC::appendImpl(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    AppendState& state) const {
+    static constexpr auto VALUE_SIZE = sizeof(TUint);
+    if (source.empty())
+        return;
+    state.uncompressed_size += static_cast<UInt32>(source.size());
+
+    // The padded pair of the pending value is encoded again, now with its real second value
+    FPCOperation<TUint> operation(dest.subspan(state.pairs_size), level, memory_resource, state.predictor_state);
+    std::size_t pairs_bytes{0};
+    if (state.has_pending) {
+        std::array<std::byte, 2 * VALUE_SIZE> pair{};
+        std::memcpy(pair.data(), &state.pending_value, VALUE_SIZE);
+        std::memcpy(pair.data() + VALUE_SIZE, source.data(), VALUE_SIZE);
+        pairs_bytes += operation.encodeMore(pair);
+        source = source.subspan(VALUE_SIZE);
+    }
+    auto pairs = source.first(source.size() / (2 * VALUE_SIZE) * (2 * VALUE_SIZE));
+    pairs_bytes += operation.encodeMore(pairs);
+    operation.saveState(state.predictor_state);
+
+    auto tail = source.subspan(pairs.size());
+    state.has_pending = !tail.empty();
+    state.pending_value = 0;
+    std::memcpy(&state.pending_value, tail.data(), tail.size());
+    state.pairs_size += static_cast<UInt32>(pairs_bytes);
+    state.compressed_size = state.pairs_size + static_cast<UInt32>(operation.encodeMore(tail));
+}
+
+AppendState CompressionCodecFPC::recoverAppendState(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size) const {
+    if (uncompressed_size % float_width != 0)
+        throw Exception("Cannot decompress. Appendable stream must hold whole values", ErrorCodes::BAD_ARGUMENTS);
+
+    auto src = compressedPayload(source, source_size);
+    AppendState state(float_width, level, memory_resource);
+    state.uncompressed_size = uncompressed_size;
+    switch (float_width) {
+        case sizeof(Float64):
+            recoverImpl<UInt64>(src, uncompressed_size / float_width, state);
             break;
+        case sizeof(Float32):
+            recoverImpl<UInt32>(src, uncompressed_size / float_width, state);
+            break;
+        default:
+            throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+    }
+    state.pairs_size += headerSize();
+    state.compressed_size += headerSize();
+    return state;
+}
+
+template <std::unsigned_integral TUint>
+void CompressionCodecFPC::recoverImpl(
+    std::span<const std::byte> source,
+    std::size_t value_count,
+    AppendState& state) const {
+    using Operation = FPCOperation<TUint>;
+
+    Operation operation({}, level, memory_resource, predictorState());
+    auto rest = source;
+    auto pair_values = value_count - value_count % 2;
+    for (std::size_t i = 0; i < pair_values; i += Operation::CHUNK_SIZE)
+        operation.decodeStep(rest, std::min(Operation::CHUNK_SIZE, pair_values - i));
+    operation.saveState(state.predictor_state);
+    state.pairs_size = static_cast<UInt32>(source.size() - rest.size());
+
+    state.has_pending = value_count % 2 != 0;
+    if (state.has_pending)
+        state.pending_value = operation.decodeStep(rest, 1).front();
+    state.compressed_size = static_cast<UInt32>(source.size() - rest.size());
+}
+
+namespace {
+
+// Stateful forward and inverse transforms of CompressionCodecFPCInteger, wrapping on overflow
+template <std::unsigned_integral TUint>
+class IntegerTransformer {
+    using TInt = std::make_signed_t<TUint>;
+
+public:
+    explicit IntegerTransformer(IntegerTransform integer_transform) noexcept
+        : transform{integer_transform} {
+    }
+
+    TUint forward(TUint value) noexcept {
+        if (transform == IntegerTransform::None)
+            return value;
+        TUint delta = value - prev_value;
+        prev_value = value;
+        if (transform == IntegerTransform::Delta)
+            return zigzag(delta);
+        TUint delta_of_delta = delta - prev_delta;
+        prev_delta = delta;
+        return zigzag(delta_of_delta);
+    }
+
+    TUint inverse(TUint value) noexcept {
+        if (transform == IntegerTransform::None)
+            return value;
+        TUint delta = unzigzag(value);
+        if (transform == IntegerTransform::DeltaOfDelta)
+            delta = prev_delta += delta;
+        return prev_value += delta;
+    }
+
+private:
+    static TUint zigzag(TUint value) noexcept {
+        return (value << 1) ^ static_cast<TUint>(static_cast<TInt>(value) >> (sizeof(TUint) * CHAR_BIT - 1));
+    }
+
+    static TUint unzigzag(TUint value) noexcept {
+        return (value >> 1) ^ (TUint{0} - (value & 1));
+    }
+
+    IntegerTransform transform;
+    TUint prev_value{0};
+    TUint prev_delta{0};
+};
+
+// prepare maps every loaded value to the integer to encode
+template <std::unsigned_integral TUint, typename Prepare, typename Statistics>
+std::size_t encodeIntegers(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    IntegerTransform transform,
+    std::pmr::memory_resource* resource,
+    Prepare&& prepare,
+    Statistics& statistics) {
+    using Operation = FPCOperation<TUint, std::endian::native, 64, Statistics>;
+
+    Operation operation(dest, level, resource);
+    IntegerTransformer<TUint> transformer(transform);
+    std::array<TUint, Operation::CHUNK_SIZE> chunk{};
+    auto count = source.size() / sizeof(TUint);
+    std::size_t written{0};
+    for (std::size_t i = 0; i < count; i += chunk.size()) {
+        auto chunk_values = std::min(chunk.size(), count - i);
+        std::memcpy(chunk.data(), source.data() + i * sizeof(TUint), chunk_values * sizeof(TUint));
+        for (std::size_t j = 0; j < chunk_values; ++j)
+            chunk[j] = transformer.forward(prepare(chunk[j]));
+        written += operation.encodeMore(std::as_bytes(std::span(chunk).first(chunk_values)));
+    }
+    statistics += operation.statistics();
+    return written;
+}
+
+// restore maps every decoded integer to the value to store
+template <std::unsigned_integral TUint, typename Restore>
+void decodeIntegers(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    IntegerTransform transform,
+    std::pmr::memory_resource* resource,
+    Restore&& restore) {
+    IntegerTransformer<TUint> transformer(transform);
+    auto* position = dest.data();
+    FPCOperation<TUint>({}, level, resource).decode(source, dest.size(), [&](std::span<const TUint> chunk) {
+        for (auto value : chunk) {
+            auto restored = restore(transformer.inverse(value));
+            std::memcpy(position, &restored, sizeof(restored));
+            position += sizeof(restored);
+        }
+    });
+}
+
+// Exponents whose powers of ten are exact doubles
+constexpr std::size_t MAX_DECIMAL_EXPONENT{18};
+
+constexpr auto POWERS_OF_TEN = [] {
+    std::array<Float64, MAX_DECIMAL_EXPONENT + 1> powers{};
+    Float64 power{1};
+    for (auto& value : powers) {
+        value = power;
+        power *= 10;
+    }
+    return powers;
+}();
+
+// Source blocks are arbitrary bytes, values are loaded without assuming alignment
+Float64 loadFloat64(std::span<const std::byte> values, std::size_t index) noexcept {
+    Float64 value{0};
+    std::memcpy(&value, values.data() + index * sizeof(Float64), sizeof(value));
+    return value;
+}
+
+// Integers up to 2^53 convert to doubles exactly, so the division is the only rounding step of decoding
+bool isExactDecimal(Float64 value, std::size_t exponent) noexcept {
+    auto scaled = value * POWERS_OF_TEN[exponent];
+    if (!(std::abs(scaled) < 0x1p53))
+        return false;
+    auto integer = static_cast<std::int64_t>(std::nearbyint(scaled));
+    return std::bit_cast<UInt64>(static_cast<Float64>(integer) / POWERS_OF_TEN[exponent]) == std::bit_cast<UInt64>(value);
+}
+
+// The smallest exponent making every value an exact decimal: grown on the values that need more digits,
+// then confirmed on all values since a value exact at one exponent may round differently at a larger one
+std::optional<std::size_t> findDecimalExponent(std::span<const std::byte> values) noexcept {
+    auto count = values.size() / sizeof(Float64);
+    std::size_t exponent{0};
+    for (std::size_t i = 0; i < count; ++i) {
+        while (!isExactDecimal(loadFloat64(values, i), exponent)) {
+            if (++exponent > MAX_DECIMAL_EXPONENT)
+                return std::nullopt;
+        }
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!isExactDecimal(loadFloat64(values, i), exponent))
+            return std::nullopt;
+    }
+    return exponent;
+}
+
+bool isExactFloat32(std::span<const std::byte> values) noexcept {
+    for (std::size_t i = 0; i < values.size() / sizeof(Float64); ++i) {
+        auto value = loadFloat64(values, i);
+        if (std::bit_cast<UInt64>(static_cast<Float64>(static_cast<Float32>(value))) != std::bit_cast<UInt64>(value))
+            return false;
     }
+    return true;
 }
+
+UInt64 toDecimalInteger(Float64 value, Float64 power) noexcept {
+    return static_cast<UInt64>(static_cast<std::int64_t>(std::nearbyint(value * power)));
+}
+
+// Values of decimal blocks are scaled to integers by 10^exponent and delta encoded
+template <typename Statistics>
+std::size_t encodeDecimal(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    std::size_t exponent,
+    std::pmr::memory_resource* resource,
+    Statistics& statistics) {
+    auto power = POWERS_OF_TEN[exponent];
+    auto to_integer = [power](UInt64 value) {
+        return toDecimalInteger(std::bit_cast<Float64>(value), power);
+    };
+    return encodeIntegers<UInt64>(source, dest, level, IntegerTransform::Delta, resource, to_integer, statistics);
+}
+
+// Float64 values of downcast blocks are encoded as Float32
+template <typename Statistics>
+std::size_t encodeDowncast(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    Statistics& statistics) {
+    using Operation = FPCOperation<UInt32, std::endian::native, 64, Statistics>;
+
+    Operation operation(dest, level, resource);
+    std::array<Float32, Operation::CHUNK_SIZE> chunk{};
+    auto count = source.size() / sizeof(Float64);
+    std::size_t written{0};
+    for (std::size_t i = 0; i < count; i += chunk.size()) {
+        auto chunk_values = std::min(chunk.size(), count - i);
+        for (std::size_t j = 0; j < chunk_values; ++j) {
+            Float64 value{0};
+            std::memcpy(&value, source.data() + (i + j) * sizeof(Float64), sizeof(value));
+            chunk[j] = static_cast<Float32>(value);
+        }
+        written += operation.encodeMore(std::as_bytes(std::span(chunk).first(chunk_values)));
+    }
+    statistics += operation.statistics();
+    return written;
+}
+
+// Maps the decoded integers of a decimal block back to the bits of its values
+class DecimalRestore {
+public:
+    explicit DecimalRestore(std::size_t exponent) noexcept
+        : power{POWERS_OF_TEN[exponent]} {
+    }
+
+    UInt64 operator()(UInt64 value) noexcept {
+        auto integer = static_cast<std::int64_t>(transformer.inverse(value));
+        return std::bit_cast<UInt64>(static_cast<Float64>(integer) / power);
+    }
+
+private:
+    Float64 power;
+    IntegerTransformer<UInt64> transformer{IntegerTransform::Delta};
+};
+
+// Maps the decoded Float32 values of a downcast block to the bits of its values
+struct DowncastRestore {
+    UInt64 operator()(UInt32 value) const noexcept {
+        return std::bit_cast<UInt64>(static_cast<Float64>(std::bit_cast<Float32>(value)));
+    }
+};
+
+// Decodes value_count values of an encoded block, consumer is called with every chunk of restored Float64 bits
+template <std::unsigned_integral TInner, typename Restore, typename Consumer>
+void decodeEncodedChunks(
+    std::span<const std::byte> source,
+    std::size_t value_count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    Restore restore,
+    Consumer&& consumer) {
+    using Operation = FPCOperation<TInner>;
+
+    std::array<UInt64, Operation::CHUNK_SIZE> restored{};
+    Operation({}, level, resource).decode(source, value_count * sizeof(TInner), [&](std::span<const TInner> chunk) {
+        for (std::size_t i = 0; i < chunk.size(); ++i)
+            restored[i] = restore(chunk[i]);
+        consumer(std::span<const UInt64>(restored).first(chunk.size()));
+    });
+}
+
+template <typename Consumer>
+void decodeEncodedChunks(
+    UInt8 encoding_flag,
+    std::size_t exponent,
+    std::span<const std::byte> source,
+    std::size_t value_count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    Consumer&& consumer) {
+    if (encoding_flag == DECIMAL_HEADER_FLAG)
+        decodeEncodedChunks<UInt64>(source, value_count, level, resource, DecimalRestore(exponent), consumer);
+    else
+        decodeEncodedChunks<UInt32>(source, value_count, level, resource, DowncastRestore{}, consumer);
+}
+
+// decompressPrefix of an encoded block, returns the number of values passed to consumer
+template <std::unsigned_integral TInner, typename Restore, typename Consumer>
+std::size_t decodeEncodedPrefix(
+    std::span<const std::byte> source,
+    std::size_t max_values,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    Restore restore,
+    Consumer&& consumer) {
+    using Operation = FPCOperation<TInner>;
+
+    std::array<UInt64, Operation::CHUNK_SIZE> restored{};
+    return Operation({}, level, resource).decodePrefix(source, max_values, [&](std::span<const TInner> chunk) {
+        for (std::size_t i = 0; i < chunk.size(); ++i)
+            restored[i] = restore(chunk[i]);
+        consumer(std::span<const UInt64>(restored).first(chunk.size()));
+    });
+}
+
+template <typename Consumer>
+std::size_t decodeEncodedPrefix(
+    UInt8 encoding_flag,
+    std::size_t exponent,
+    std::span<const std::byte> source,
+    std::size_t max_values,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    Consumer&& consumer) {
+    if (encoding_flag == DECIMAL_HEADER_FLAG)
+        return decodeEncodedPrefix<UInt64>(source, max_values, level, resource, DecimalRestore(exponent), consumer);
+    return decodeEncodedPrefix<UInt32>(source, max_values, level, resource, DowncastRestore{}, consumer);
+}
+
+void decodeEncodedBlock(
+    UInt8 encoding_flag,
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    std::size_t exponent,
+    std::pmr::memory_resource* resource) {
+    auto* position = dest.data();
+    auto store = [&position](std::span<const UInt64> chunk) {
+        std::memcpy(position, chunk.data(), chunk.size_bytes());
+        position += chunk.size_bytes();
+    };
+    decodeEncodedChunks(encoding_flag, exponent, source, dest.size() / sizeof(Float64), level, resource, store);
+}
+
+void decodeDecimal(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    std::size_t exponent,
+    std::pmr::memory_resource* resource) {
+    decodeEncodedBlock(DECIMAL_HEADER_FLAG, source, dest, level, exponent, resource);
+}
+
+void decodeDowncast(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    std::pmr::memory_resource* resource) {
+    decodeEncodedBlock(DOWNCAST_HEADER_FLAG, source, dest, level, 0, resource);
+}
+
+// Float64 values read by sampling source, each window with the value before it which delta runs start from
+std::pmr::vector<std::byte> sampledWindows(std::span<const std::byte> source, std::pmr::memory_resource* resource) {
+    static constexpr std::size_t WINDOW_SIZE{(SAMPLE_WARMUP_VALUES + SAMPLE_VALUES + 1) * sizeof(Float64)};
+    auto stride = source.size() / sizeof(Float64) / SAMPLE_WINDOWS * sizeof(Float64);
+    std::pmr::vector<std::byte> windows(resource);
+    windows.reserve(SAMPLE_WINDOWS * WINDOW_SIZE);
+    for (std::size_t window = 0; window < SAMPLE_WINDOWS; ++window) {
+        auto first = window == 0 ? 0 : window * stride - sizeof(Float64);
+        auto size = window == 0 ? WINDOW_SIZE - sizeof(Float64) : WINDOW_SIZE;
+        windows.insert(windows.end(), source.begin() + first, source.begin() + first + size);
+    }
+    return windows;
+}
+
+// Measures the inner values of an encoded block, runs are converted the way encodeDecimal and encodeDowncast do
+SampledSize sampleEncodedBlock(
+    UInt8 encoding_flag,
+    std::size_t exponent,
+    std::span<const std::byte> source,
+    UInt8 level,
+    std::pmr::memory_resource* resource) {
+    auto count = source.size() / sizeof(Float64);
+    if (encoding_flag == DECIMAL_HEADER_FLAG) {
+        auto power = POWERS_OF_TEN[exponent];
+        std::pmr::vector<UInt64> values(resource);
+        // Deltas of a run start from the value before it
+        auto run = [&](std::size_t first, std::size_t run_count) {
+            IntegerTransformer<UInt64> transformer(IntegerTransform::Delta);
+            if (first != 0)
+                transformer.forward(toDecimalInteger(loadFloat64(source, first - 1), power));
+            values.resize(run_count);
+            for (std::size_t i = 0; i < run_count; ++i)
+                values[i] = transformer.forward(toDecimalInteger(loadFloat64(source, first + i), power));
+            return std::as_bytes(std::span(values));
+        };
+        return sampleCompressedSize<UInt64>(count, level, resource, {}, run);
+    }
+    std::pmr::vector<Float32> values(resource);
+    auto run = [&](std::size_t first, std::size_t run_count) {
+        values.resize(run_count);
+        for (std::size_t i = 0; i < run_count; ++i)
+            values[i] = static_cast<Float32>(loadFloat64(source, first + i));
+        return std::as_bytes(std::span(values));
+    };
+    return sampleCompressedSize<UInt32>(count, level, resource, {}, run);
+}
+
+}
+
+CompressionEstimate CompressionCodecFPC::estimateCompressedSize(const char* source, UInt32 source_size) const {
+    auto src = std::as_bytes(std::span(source, source_size));
+    // Encodings of sampled inputs are chosen on the sampled windows, a full pass would cost more than sampling
+    auto encoding_probe = src;
+    std::pmr::vector<std::byte> windows(memory_resource);
+    if (float_width == sizeof(Float64) && block_encodings != BlockEncodings::None
+        && source_size % sizeof(Float64) == 0 && source_size / sizeof(Float64) >= MIN_SAMPLED_VALUES) {
+        windows = sampledWindows(src, memory_resource);
+        encoding_probe = windows;
+    }
+
+    SampledSize sampled{};
+    auto header_size = headerSize();
+    if (auto block = chooseBlockEncoding(encoding_probe)) {
+        sampled = sampleEncodedBlock(block->flag, block->exponent, src, level, memory_resource);
+        header_size = encodedBlockHeaderSize(block->flag);
+    } else if (float_width == sizeof(Float64)) {
+        sampled = sampleCompressedSize<UInt64>(src, level, memory_resource, predictorState());
+    } else if (float_width == sizeof(Float32)) {
+        sampled = sampleCompressedSize<UInt32>(src, level, memory_resource, predictorState());
+    } else {
+        throw Exception("Cannot compress. Incorrect float width", ErrorCodes::CANNOT_COMPRESS);
+    }
+
+    auto values = static_cast<double>((source_size + float_width - 1) / float_width);
+    auto estimated_size = header_size + sampled.bytes_per_value * values;
+    auto compressed_size = std::min(static_cast<UInt32>(std::ceil(estimated_size)), getMaxCompressedDataSize(source_size));
+    auto ratio = source_size / estimated_size;
+    auto ratio_error = sampled.bytes_per_value == 0 ? 0.0 : ratio * sampled.bytes_per_value_error / sampled.bytes_per_value;
+    return {compressed_size, ratio, ratio_error};
+}
+
+namespace {
+
+// Reused for all blocks a thread processes, reset before every block
+template <std::unsigned_integral TUint>
+using FrameOperation = FPCOperation<TUint, std::endian::native, 64, NoEncoderStatistics, BlockChecksum>;
+
+// Frame blocks are dispatched together with the plain streams, so the checksum loops get the same code generation
+template <std::unsigned_integral TUint>
+std::size_t compressFrameBlock(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    FrameOperation<TUint>& operation,
+    FrameChecksum frame_checksum);
+
+template <std::unsigned_integral TUint>
+std::size_t decompressFrameBlock(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    FrameOperation<TUint>& operation,
+    FrameChecksum frame_checksum);
+
+template <std::unsigned_integral TUint>
+std::size_t encodeKernel(
+    std::span<std::byte> dest,
+    std::span<const std::byte> source,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    return FPCOperation<TUint>(dest, level, resource, predictor_state).encode(source);
+}
+
+template <std::unsigned_integral TUint>
+std::size_t decodeKernel(
+    std::span<std::byte> dest,
+    std::span<const std::byte> source,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    return FPCOperation<TUint>(dest, level, resource, predictor_state).decode(source, dest.size());
+}
+
+template <std::unsigned_integral TUint>
+void batchDecodeKernel(std::span<const BatchStream> streams, UInt8 level, std::pmr::memory_resource* resource) {
+    if (2 * (std::size_t{1} << level) * sizeof(TUint) * BATCH_LANES >= BATCH_TABLES_BUDGET) {
+        for (const auto& stream : streams)
+            FPCOperation<TUint>(stream.dest, level, resource).decode(stream.source, stream.dest.size());
+        return;
+    }
+
+    BatchDecoder<TUint, BATCH_LANES> decoder(level, resource);
+    for (std::size_t i = 0; i < streams.size(); i += BATCH_LANES)
+        decoder.decode(streams.subspan(i, std::min(BATCH_LANES, streams.size() - i)));
+}
+
+template <std::unsigned_integral TUint>
+std::size_t encodeStridedKernel(
+    std::span<std::byte> dest,
+    const std::byte* base,
+    std::size_t stride,
+    std::size_t count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    return FPCOperation<TUint>(dest, level, resource, predictor_state).encodeStrided(base, stride, count);
+}
+
+template <std::unsigned_integral TUint>
+void decodeStridedKernel(
+    std::span<const std::byte> source,
+    std::byte* base,
+    std::size_t stride,
+    std::size_t count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    FPCOperation<TUint>({}, level, resource, predictor_state).decodeStrided(source, base, stride, count);
+}
+
+template <std::unsigned_integral TUint>
+std::size_t decodePrefixKernel(
+    std::span<std::byte> dest,
+    std::span<const std::byte> source,
+    std::size_t max_values,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    return FPCOperation<TUint>(dest, level, resource, predictor_state).decodePrefix(source, max_values);
+}
+
+template <std::unsigned_integral TUint>
+std::size_t encodeIntegersKernel(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    IntegerTransform transform,
+    std::pmr::memory_resource* resource) {
+    NoEncoderStatistics statistics;
+    return encodeIntegers<TUint>(source, dest, level, transform, resource, std::identity{}, statistics);
+}
+
+template <std::unsigned_integral TUint>
+void decodeIntegersKernel(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    UInt8 level,
+    IntegerTransform transform,
+    std::pmr::memory_resource* resource) {
+    decodeIntegers<TUint>(source, dest, level, transform, resource, std::identity{});
+}
+
+using CodecKernel = std::size_t (*)(
+    std::span<std::byte>, std::span<const std::byte>, UInt8, std::pmr::memory_resource*, std::span<const std::byte>);
+using StridedEncodeKernel = std::size_t (*)(
+    std::span<std::byte>, const std::byte*, std::size_t, std::size_t, UInt8, std::pmr::memory_resource*,
+    std::span<const std::byte>);
+using StridedDecodeKernel = void (*)(
+    std::span<const std::byte>, std::byte*, std::size_t, std::size_t, UInt8, std::pmr::memory_resource*,
+    std::span<const std::byte>);
+using PrefixKernel = std::size_t (*)(
+    std::span<std::byte>, std::span<const std::byte>, std::size_t, UInt8, std::pmr::memory_resource*,
+    std::span<const std::byte>);
+using IntegerEncodeKernel = std::size_t (*)(
+    std::span<const std::byte>, std::span<std::byte>, UInt8, IntegerTransform, std::pmr::memory_resource*);
+using IntegerDecodeKernel = void (*)(
+    std::span<const std::byte>, std::span<std::byte>, UInt8, IntegerTransform, std::pmr::memory_resource*);
+using DecimalEncodeKernel = std::size_t (*)(
+    std::span<const std::byte>, std::span<std::byte>, UInt8, std::size_t, std::pmr::memory_resource*);
+using DecimalDecodeKernel = void (*)(
+    std::span<const std::byte>, std::span<std::byte>, UInt8, std::size_t, std::pmr::memory_resource*);
+using DowncastEncodeKernel = std::size_t (*)(
+    std::span<const std::byte>, std::span<std::byte>, UInt8, std::pmr::memory_resource*);
+using DowncastDecodeKernel = void (*)(
+    std::span<const std::byte>, std::span<std::byte>, UInt8, std::pmr::memory_resource*);
+template <std::unsigned_integral TUint>
+using FrameBlockKernel = std::size_t (*)(
+    std::span<const std::byte>, std::span<std::byte>, FrameOperation<TUint>&, FrameChecksum);
+using BatchKernel = void (*)(std::span<const BatchStream>, UInt8, std::pmr::memory_resource*);
+
+template <std::unsigned_integral TUint>
+struct KernelTable {
+    CodecKernel encode;
+    CodecKernel decode;
+    FrameBlockKernel<TUint> compress_block;
+    FrameBlockKernel<TUint> decompress_block;
+    BatchKernel batch_decode;
+    StridedEncodeKernel encode_strided;
+    StridedDecodeKernel decode_strided;
+    PrefixKernel decode_prefix;
+    IntegerEncodeKernel encode_integers;
+    IntegerDecodeKernel decode_integers;
+};
+
+// Encoded blocks hold Float64 values only
+struct BlockEncodingKernels {
+    DecimalEncodeKernel encode_decimal;
+    DecimalDecodeKernel decode_decimal;
+    DowncastEncodeKernel encode_downcast;
+    DowncastDecodeKernel decode_downcast;
+};
+
+struct IsaKernels {
+    std::string_view isa;
+    KernelTable<UInt64> wide;
+    KernelTable<UInt32> narrow;
+    BlockEncodingKernels block_encodings;
+
+    template <std::unsigned_integral TUint>
+    const KernelTable<TUint>& table() const noexcept {
+        if constexpr (sizeof(TUint) == sizeof(UInt64))
+            return wide;
+        else
+            return narrow;
+    }
+};
+
+// Instantiates the kernels for one instruction set. flatten inlines the whole FPCOperation
+// into every kernel, so pair coding, chunk import/export and checksums are compiled for that target.
+#define FPC_CODEC_ISA_KERNELS(NAME, TARGET) \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t encode##NAME( \
+        std::span<std::byte> dest, std::span<const std::byte> source, UInt8 level, \
+        std::pmr::memory_resource* resource, std::span<const std::byte> predictor_state) { \
+        return encodeKernel<TUint>(dest, source, level, resource, predictor_state); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t decode##NAME( \
+        std::span<std::byte> dest, std::span<const std::byte> source, UInt8 level, \
+        std::pmr::memory_resource* resource, std::span<const std::byte> predictor_state) { \
+        return decodeKernel<TUint>(dest, source, level, resource, predictor_state); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t compressBlock##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, FrameOperation<TUint>& operation, \
+        FrameChecksum checksum) { \
+        return compressFrameBlock<TUint>(source, dest, operation, checksum); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t decompressBlock##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, FrameOperation<TUint>& operation, \
+        FrameChecksum checksum) { \
+        return decompressFrameBlock<TUint>(source, dest, operation, checksum); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) void batchDecode##NAME( \
+        std::span<const BatchStream> streams, UInt8 level, std::pmr::memory_resource* resource) { \
+        batchDecodeKernel<TUint>(streams, level, resource); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t encodeStrided##NAME( \
+        std::span<std::byte> dest, const std::byte* base, std::size_t stride, std::size_t count, UInt8 level, \
+        std::pmr::memory_resource* resource, std::span<const std::byte> predictor_state) { \
+        return encodeStridedKernel<TUint>(dest, base, stride, count, level, resource, predictor_state); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) void decodeStrided##NAME( \
+        std::span<const std::byte> source, std::byte* base, std::size_t stride, std::size_t count, UInt8 level, \
+        std::pmr::memory_resource* resource, std::span<const std::byte> predictor_state) { \
+        decodeStridedKernel<TUint>(source, base, stride, count, level, resource, predictor_state); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t decodePrefix##NAME( \
+        std::span<std::byte> dest, std::span<const std::byte> source, std::size_t max_values, UInt8 level, \
+        std::pmr::memory_resource* resource, std::span<const std::byte> predictor_state) { \
+        return decodePrefixKernel<TUint>(dest, source, max_values, level, resource, predictor_state); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) std::size_t encodeIntegers##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, UInt8 level, IntegerTransform transform, \
+        std::pmr::memory_resource* resource) { \
+        return encodeIntegersKernel<TUint>(source, dest, level, transform, resource); \
+    } \
+    template <std::unsigned_integral TUint> \
+    __attribute__((target(TARGET), flatten)) void decodeIntegers##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, UInt8 level, IntegerTransform transform, \
+        std::pmr::memory_resource* resource) { \
+        decodeIntegersKernel<TUint>(source, dest, level, transform, resource); \
+    } \
+    template <std::unsigned_integral TUint> \
+    constexpr KernelTable<TUint> NAME##_KERNELS{ \
+        &encode##NAME<TUint>, &decode##NAME<TUint>, &compressBlock##NAME<TUint>, &decompressBlock##NAME<TUint>, \
+        &batchDecode##NAME<TUint>, &encodeStrided##NAME<TUint>, &decodeStrided##NAME<TUint>, \
+        &decodePrefix##NAME<TUint>, &encodeIntegers##NAME<TUint>, &decodeIntegers##NAME<TUint>}; \
+    __attribute__((target(TARGET), flatten)) std::size_t encodeDecimal##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, UInt8 level, std::size_t exponent, \
+        std::pmr::memory_resource* resource) { \
+        NoEncoderStatistics statistics; \
+        return encodeDecimal(source, dest, level, exponent, resource, statistics); \
+    } \
+    __attribute__((target(TARGET), flatten)) void decodeDecimal##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, UInt8 level, std::size_t exponent, \
+        std::pmr::memory_resource* resource) { \
+        decodeDecimal(source, dest, level, exponent, resource); \
+    } \
+    __attribute__((target(TARGET), flatten)) std::size_t encodeDowncast##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, UInt8 level, \
+        std::pmr::memory_resource* resource) { \
+        NoEncoderStatistics statistics; \
+        return encodeDowncast(source, dest, level, resource, statistics); \
+    } \
+    __attribute__((target(TARGET), flatten)) void decodeDowncast##NAME( \
+        std::span<const std::byte> source, std::span<std::byte> dest, UInt8 level, \
+        std::pmr::memory_resource* resource) { \
+        decodeDowncast(source, dest, level, resource); \
+    } \
+    constexpr BlockEncodingKernels NAME##_BLOCK_ENCODING_KERNELS{ \
+        &encodeDecimal##NAME, &decodeDecimal##NAME, &encodeDowncast##NAME, &decodeDowncast##NAME};
+
+FPC_CODEC_ISA_KERNELS(Scalar, "default")
+
+#if defined(__x86_64__)
+FPC_CODEC_ISA_KERNELS(Sse4, "sse4.2,popcnt")
+FPC_CODEC_ISA_KERNELS(Avx2, "avx2,bmi,bmi2,lzcnt,popcnt")
+FPC_CODEC_ISA_KERNELS(Avx512, "avx512f,avx512bw,avx512dq,avx512vl,bmi,bmi2,lzcnt,popcnt")
+#endif
+
+#undef FPC_CODEC_ISA_KERNELS
+
+// Ordered from the most to the least capable
+constexpr std::array ISA_KERNELS{
+#if defined(__x86_64__)
+    IsaKernels{"avx512", Avx512_KERNELS<UInt64>, Avx512_KERNELS<UInt32>, Avx512_BLOCK_ENCODING_KERNELS},
+    IsaKernels{"avx2", Avx2_KERNELS<UInt64>, Avx2_KERNELS<UInt32>, Avx2_BLOCK_ENCODING_KERNELS},
+    IsaKernels{"sse4", Sse4_KERNELS<UInt64>, Sse4_KERNELS<UInt32>, Sse4_BLOCK_ENCODING_KERNELS},
+#endif
+    IsaKernels{"scalar", Scalar_KERNELS<UInt64>, Scalar_KERNELS<UInt32>, Scalar_BLOCK_ENCODING_KERNELS},
+};
+
+bool isaSupported(std::string_view isa) {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (isa == "avx512")
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")
+            && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("lzcnt");
+    if (isa == "avx2")
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("lzcnt");
+    if (isa == "sse4")
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+#endif
+    return isa == "scalar";
+}
+
+// FPC_CODEC_ISA=scalar|sse4|avx2|avx512 caps the instruction set for testing,
+// an unknown or unsupported value leaves the best supported one
+const IsaKernels& selectKernels() {
+    std::string_view requested;
+    if (const auto* isa = std::getenv("FPC_CODEC_ISA"))
+        requested = isa;
+
+    auto first = ISA_KERNELS.begin();
+    for (auto it = first; it != ISA_KERNELS.end(); ++it) {
+        if (it->isa == requested && isaSupported(it->isa)) {
+            first = it;
+            break;
+        }
+    }
+    for (auto it = first; it != ISA_KERNELS.end(); ++it) {
+        if (isaSupported(it->isa))
+            return *it;
+    }
+    return ISA_KERNELS.back();
+}
+
+// Resolved once on the first use
+const IsaKernels& dispatchedKernels() {
+    static const IsaKernels& kernels = selectKernels();
+    return kernels;
+}
+
+}
+
+std::string_view CompressionCodecFPC::getDispatchedIsa() {
+    return dispatchedKernels().isa;
+}
+
+UInt32 CompressionCodecFPC::doCompressData(const char* source, UInt32 source_size, char* dest) const {
+    NoEncoderStatistics statistics;
+    return compressImpl(source, source_size, dest, statistics);
+}
+
+UInt32 CompressionCodecFPC::doCompressData(
+    const char* source,
+    UInt32 source_size,
+    char* dest,
+    EncoderStatistics& statistics) const {
+    return compressImpl(source, source_size, dest, statistics);
+}
+
+void CompressionCodecFPC::writeHeader(char* dest) const {
+    dest[0] = static_cast<char>(float_width);
+    dest[1] = static_cast<char>(level);
+    dest[2] = static_cast<char>(encodeEndianness(std::endian::native));
+    if (predictor_snapshot != nullptr) {
+        dest[2] = static_cast<char>(dest[2] | SNAPSHOT_HEADER_FLAG);
+        auto id = predictor_snapshot->getId();
+        std::memcpy(dest + HEADER_SIZE, &id, sizeof(id));
+    }
+}
+
+template <typename Statistics>
+UInt32 CompressionCodecFPC::compressImpl(const char* source, UInt32 source_size, char* dest, Statistics& statistics) const {
+    if (auto block = chooseBlockEncoding(std::as_bytes(std::span(source, source_size))))
+        return compressEncodedBlock(*block, dest, statistics);
+
+    writeHeader(dest);
+
+    auto destination = std::as_writable_bytes(
+        std::span(dest, getMaxCompressedDataSize(source_size)).subspan(headerSize()));
+    auto src = std::as_bytes(std::span(source, source_size));
+    if constexpr (std::is_same_v<Statistics, NoEncoderStatistics>) {
+        switch (float_width) {
+            case sizeof(Float64):
+                return headerSize() + static_cast<UInt32>(dispatchedKernels().table<UInt64>().encode(
+                    destination, src, level, memory_resource, predictorState()));
+            case sizeof(Float32):
+                return headerSize() + static_cast<UInt32>(dispatchedKernels().table<UInt32>().encode(
+                    destination, src, level, memory_resource, predictorState()));
+            default:
+                break;
+        }
+    }
+
+    switch (float_width) {
+        case sizeof(Float64): {
+            FPCOperation<UInt64, std::endian::native, 64, Statistics> operation(
+                destination, level, memory_resource, predictorState());
+            auto compressed_size = std::move(operation).encode(src);
+            statistics += operation.statistics();
+            return headerSize() + compressed_size;
+        }
+        case sizeof(Float32): {
+            FPCOperation<UInt32, std::endian::native, 64, Statistics> operation(
+                destination, level, memory_resource, predictorState());
+            auto compressed_size = std::move(operation).encode(src);
+            statistics += operation.statistics();
+            return headerSize() + compressed_size;
+        }
+        default:
+            break;
+    }
+    throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+}
+
+UInt32 CompressionCodecFPC::doCompressStrided(const char* source, std::size_t stride, UInt32 count, char* dest) const {
+    writeHeader(dest);
+
+    auto source_size = static_cast<UInt64>(count) * float_width;
+    if (source_size > std::numeric_limits<UInt32>::max())
+        throw Exception("Cannot compress. Data is too large, use doCompressFrame", ErrorCodes::CANNOT_COMPRESS);
+    auto destination = std::as_writable_bytes(
+        std::span(dest, getMaxCompressedDataSize(static_cast<UInt32>(source_size))).subspan(headerSize()));
+    const auto* base = reinterpret_cast<const std::byte*>(source);
+    switch (float_width) {
+        case sizeof(Float64):
+            return headerSize() + static_cast<UInt32>(dispatchedKernels().table<UInt64>().encode_strided(
+                destination, base, stride, count, level, memory_resource, predictorState()));
+        case sizeof(Float32):
+            return headerSize() + static_cast<UInt32>(dispatchedKernels().table<UInt32>().encode_strided(
+                destination, base, stride, count, level, memory_resource, predictorState()));
+        default:
+            break;
+    }
+    throw Exception("Cannot compress. Incorrect float width", ErrorCodes::CANNOT_COMPRESS);
+}
+
+void CompressionCodecFPC::doDecompressStrided(
+    const char* source,
+    UInt32 source_size,
+    char* dest,
+    std::size_t stride,
+    UInt32 count) const {
+    auto* base = reinterpret_cast<std::byte*>(dest);
+    if (auto block = encodedBlock(source, source_size)) {
+        auto scatter = [&base, stride](std::span<const UInt64> chunk) {
+            for (auto value : chunk) {
+                std::memcpy(base, &value, sizeof(value));
+                base += stride;
+            }
+        };
+        decodeEncodedChunks(block->flag, block->exponent, block->values, count, level, memory_resource, scatter);
+        return;
+    }
+
+    auto src = compressedPayload(source, source_size);
+    switch (float_width) {
+        case sizeof(Float64):
+            dispatchedKernels().table<UInt64>().decode_strided(
+                src, base, stride, count, level, memory_resource, predictorState());
+            break;
+        case sizeof(Float32):
+            dispatchedKernels().table<UInt32>().decode_strided(
+                src, base, stride, count, level, memory_resource, predictorState());
+            break;
+        default:
+            break;
+    }
+}
+
+void CompressionCodecFPC::doDecompressBatch(std::span<const DecompressionTask> tasks) const {
+    // Lanes of the batch decoder start from empty tables and decode plain FPC only
+    auto is_encoded_block = [](const DecompressionTask& task) {
+        return task.source_size >= HEADER_SIZE
+            && (static_cast<UInt8>(task.source[2]) & BLOCK_ENCODING_HEADER_FLAGS) != 0;
+    };
+    if (predictor_snapshot != nullptr || std::ranges::any_of(tasks, is_encoded_block)) {
+        for (const auto& task : tasks)
+            doDecompressData(task.source, task.source_size, task.dest, task.uncompressed_size);
+        return;
+    }
+
+    std::pmr::vector<BatchStream> streams(memory_resource);
+    streams.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        streams.push_back({
+            compressedPayload(task.source, task.source_size),
+            std::as_writable_bytes(std::span(task.dest, task.uncompressed_size))});
+    }
+
+    switch (float_width) {
+        case sizeof(Float64):
+            dispatchedKernels().table<UInt64>().batch_decode(streams, level, memory_resource);
+            break;
+        case sizeof(Float32):
+            dispatchedKernels().table<UInt32>().batch_decode(streams, level, memory_resource);
+            break;
+        default:
+            break;
+    }
+}
+
+std::span<const std::byte> CompressionCodecFPC::compressedPayload(const char* source, UInt32 source_size) const {
+    if (source_size < HEADER_SIZE)
+        throw Exception("Cannot decompress. File has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+
+    auto compressed_data = std::span(source, source_size);
+    if (static_cast<UInt8>(compressed_data[0]) != float_width)
+        throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+    if (static_cast<UInt8>(compressed_data[1]) != level)
+        throw Exception("Cannot decompress. File has incorrect compression level", ErrorCodes::CANNOT_DECOMPRESS);
+    auto flags = static_cast<UInt8>(compressed_data[2]);
+    if ((flags & INTEGER_HEADER_FLAG) != 0)
+        throw Exception("Cannot decompress. File holds integers", ErrorCodes::CANNOT_DECOMPRESS);
+    if ((flags & BLOCK_ENCODING_HEADER_FLAGS) != 0)
+        throw Exception("Cannot decompress. Encoded blocks are not appendable", ErrorCodes::CANNOT_DECOMPRESS);
+    if (decodeEndianness(static_cast<UInt8>(flags & ~SNAPSHOT_HEADER_FLAG)) != std::endian::native)
+        throw Exception("Cannot decompress. File has incorrect endianness", ErrorCodes::CANNOT_DECOMPRESS);
+    if (((flags & SNAPSHOT_HEADER_FLAG) != 0) != (predictor_snapshot != nullptr))
+        throw Exception("Cannot decompress. File and codec disagree on predictor snapshot", ErrorCodes::CANNOT_DECOMPRESS);
+    if (predictor_snapshot != nullptr) {
+        UInt32 id{0};
+        if (source_size < MAX_HEADER_SIZE)
+            throw Exception("Cannot decompress. File has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+        std::memcpy(&id, source + HEADER_SIZE, sizeof(id));
+        if (id != predictor_snapshot->getId())
+            throw Exception("Cannot decompress. File has different predictor snapshot", ErrorCodes::CANNOT_DECOMPRESS);
+    }
+    return std::as_bytes(compressed_data.subspan(headerSize()));
+}
+
+void CompressionCodecFPC::doDecompressData(
+    const char* source,
+    UInt32 source_size,
+    char* dest,
+    UInt32 uncompressed_size) const {
+    auto destination = std::as_writable_bytes(std::span(dest, uncompressed_size));
+    if (auto block = encodedBlock(source, source_size)) {
+        if (uncompressed_size % sizeof(Float64) != 0)
+            throw Exception("Cannot decompress. Encoded block holds whole values", ErrorCodes::CANNOT_DECOMPRESS);
+        const auto& kernels = dispatchedKernels().block_encodings;
+        if (block->flag == DECIMAL_HEADER_FLAG)
+            kernels.decode_decimal(block->values, destination, level, block->exponent, memory_resource);
+        else
+            kernels.decode_downcast(block->values, destination, level, memory_resource);
+        return;
+    }
+
+    auto src = compressedPayload(source, source_size);
+    switch (float_width) {
+        case sizeof(Float64):
+            dispatchedKernels().table<UInt64>().decode(destination, src, level, memory_resource, predictorState());
+            break;
+        case sizeof(Float32):
+            dispatchedKernels().table<UInt32>().decode(destination, src, level, memory_resource, predictorState());
+            break;
+        default:
+            break;
+    }
+}
+
+void CompressionCodecFPC::doDecompressInPlace(
+    char* buffer,
+    UInt32 buffer_size,
+    UInt32 source_size,
+    UInt32 uncompressed_size) const {
+    if (source_size > buffer_size || buffer_size < uncompressed_size
+        || buffer_size - uncompressed_size < getInPlaceDecompressionMargin(uncompressed_size))
+        throw Exception("Cannot decompress. Buffer is too small for in-place decoding", ErrorCodes::BAD_ARGUMENTS);
+
+    doDecompressData(buffer + (buffer_size - source_size), source_size, buffer, uncompressed_size);
+}
+
+UInt32 CompressionCodecFPC::decompressPrefix(const char* source, UInt32 source_size, char* dest, UInt32 max_values) const {
+    auto destination = std::as_writable_bytes(std::span(dest, static_cast<std::size_t>(max_values) * float_width));
+    if (auto block = encodedBlock(source, source_size)) {
+        auto* position = destination.data();
+        auto store = [&position](std::span<const UInt64> chunk) {
+            std::memcpy(position, chunk.data(), chunk.size_bytes());
+            position += chunk.size_bytes();
+        };
+        return static_cast<UInt32>(decodeEncodedPrefix(
+            block->flag, block->exponent, block->values, max_values, level, memory_resource, store));
+    }
+
+    auto src = compressedPayload(source, source_size);
+    switch (float_width) {
+        case sizeof(Float64):
+            return static_cast<UInt32>(dispatchedKernels().table<UInt64>().decode_prefix(
+                destination, src, max_values, level, memory_resource, predictorState()));
+        case sizeof(Float32):
+            return static_cast<UInt32>(dispatchedKernels().table<UInt32>().decode_prefix(
+                destination, src, max_values, level, memory_resource, predictorState()));
+        default:
+            break;
+    }
+    throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+}
+
+template <std::floating_point Float, typename Func>
+void CompressionCodecFPC::decompressForEach(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size,
+    Func&& func) const {
+    static_assert(sizeof(Float) == sizeof(Float32) || sizeof(Float) == sizeof(Float64));
+    using TUint = std::conditional_t<sizeof(Float) == sizeof(Float64), UInt64, UInt32>;
+    using Operation = FPCOperation<TUint>;
+
+    if (sizeof(Float) != float_width)
+        throw Exception("Cannot decompress. Requested type does not match float width", ErrorCodes::BAD_ARGUMENTS);
+
+    std::array<Float, Operation::CHUNK_SIZE> values{};
+    if constexpr (sizeof(Float) == sizeof(Float64)) {
+        if (auto block = encodedBlock(source, source_size)) {
+            auto on_chunk = [&](std::span<const UInt64> chunk) {
+                for (std::size_t i = 0; i < chunk.size(); ++i)
+                    values[i] = std::bit_cast<Float>(chunk[i]);
+                func(std::span<const Float>(values.data(), chunk.size()));
+            };
+            decodeEncodedChunks(
+                block->flag, block->exponent, block->values, uncompressed_size / sizeof(Float), level, memory_resource,
+                on_chunk);
+            return;
+        }
+    }
+
+    auto src = compressedPayload(source, source_size);
+    Operation operation({}, level, memory_resource, predictorState());
+    std::move(operation).decode(src, uncompressed_size, [&](std::span<const TUint> chunk) {
+        for (std::size_t i = 0; i < chunk.size(); ++i)
+            values[i] = std::bit_cast<Float>(chunk[i]);
+        func(std::span<const Float>(values.data(), chunk.size()));
+    });
+}
+
+namespace {
+
+template <std::floating_point Float, std::size_t ChunkSize>
+Generator<std::span<const Float>> generateChunks(
+    std::span<const std::byte> source,
+    std::size_t value_count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    std::span<const std::byte> predictor_state) {
+    using TUint = std::conditional_t<sizeof(Float) == sizeof(Float64), UInt64, UInt32>;
+
+    FPCOperation<TUint, std::endian::native, ChunkSize> operation({}, level, resource, predictor_state);
+    std::array<Float, ChunkSize> values{};
+    for (std::size_t i = 0; i < value_count; i += ChunkSize) {
+        auto chunk = operation.decodeStep(source, std::min(ChunkSize, value_count - i));
+        for (std::size_t j = 0; j < chunk.size(); ++j)
+            values[j] = std::bit_cast<Float>(chunk[j]);
+        co_yield std::span<const Float>(values.data(), chunk.size());
+    }
+}
+
+template <std::floating_point Float, std::size_t ChunkSize, std::unsigned_integral TInner, typename Restore>
+Generator<std::span<const Float>> generateEncodedChunks(
+    std::span<const std::byte> source,
+    std::size_t value_count,
+    UInt8 level,
+    std::pmr::memory_resource* resource,
+    Restore restore) {
+    FPCOperation<TInner, std::endian::native, ChunkSize> operation({}, level, resource);
+    std::array<Float, ChunkSize> values{};
+    for (std::size_t i = 0; i < value_count; i += ChunkSize) {
+        auto chunk = operation.decodeStep(source, std::min(ChunkSize, value_count - i));
+        for (std::size_t j = 0; j < chunk.size(); ++j)
+            values[j] = std::bit_cast<Float>(restore(chunk[j]));
+        co_yield std::span<const Float>(values.data(), chunk.size());
+    }
+}
+
+template <std::floating_point Float, std::size_t ChunkSize>
+Generator<std::span<const Float>> generateEncodedChunks(
+    UInt8 encoding_flag,
+    std::size_t exponent,
+    std::span<const std::byte> source,
+    std::size_t value_count,
+    UInt8 level,
+    std::pmr::memory_resource* resource) {
+    if (encoding_flag == DECIMAL_HEADER_FLAG) {
+        return generateEncodedChunks<Float, ChunkSize, UInt64>(
+            source, value_count, level, resource, DecimalRestore(exponent));
+    }
+    return generateEncodedChunks<Float, ChunkSize, UInt32>(source, value_count, level, resource, DowncastRestore{});
+}
+
+}
+
+template <std::floating_point Float, std::size_t ChunkSize>
+Generator<std::span<const Float>> CompressionCodecFPC::decompressChunks(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size) const {
+    static_assert(sizeof(Float) == sizeof(Float32) || sizeof(Float) == sizeof(Float64));
+    if (sizeof(Float) != float_width)
+        throw Exception("Cannot decompress. Requested type does not match float width", ErrorCodes::BAD_ARGUMENTS);
+
+    if constexpr (sizeof(Float) == sizeof(Float64)) {
+        if (auto block = encodedBlock(source, source_size)) {
+            return generateEncodedChunks<Float, ChunkSize>(
+                block->flag, block->exponent, block->values, uncompressed_size / sizeof(Float), level, memory_resource);
+        }
+    }
+
+    auto src = compressedPayload(source, source_size);
+    return generateChunks<Float, ChunkSize>(
+        src, uncompressed_size / sizeof(Float), level, memory_resource, predictorState());
+}
+
+template <std::floating_point Float>
+DecodedView<Float> CompressionCodecFPC::decodedView(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size) const {
+    return DecodedView<Float>(decompressChunks<Float, 2>(source, source_size, uncompressed_size));
+}
+
+template <std::floating_point Float>
+Float64 CompressionCodecFPC::decompressSum(const char* source, UInt32 source_size, UInt32 uncompressed_size) const {
+    // Independent partial sums let the additions of a chunk overlap
+    std::array<Float64, 4> partial{};
+    decompressForEach<Float>(source, source_size, uncompressed_size, [&partial](std::span<const Float> values) {
+        for (std::size_t i = 0; i < values.size(); ++i)
+            partial[i % partial.size()] += values[i];
+    });
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+
+template <std::floating_point Float>
+Float CompressionCodecFPC::decompressMin(const char* source, UInt32 source_size, UInt32 uncompressed_size) const {
+    auto result = std::numeric_limits<Float>::infinity();
+    decompressForEach<Float>(source, source_size, uncompressed_size, [&result](std::span<const Float> values) {
+        for (auto value : values)
+            result = value < result ? value : result;
+    });
+    return result;
+}
+
+template <std::floating_point Float>
+Float CompressionCodecFPC::decompressMax(const char* source, UInt32 source_size, UInt32 uncompressed_size) const {
+    auto result = -std::numeric_limits<Float>::infinity();
+    decompressForEach<Float>(source, source_size, uncompressed_size, [&result](std::span<const Float> values) {
+        for (auto value : values)
+            result = value > result ? value : result;
+    });
+    return result;
+}
+
+template <std::floating_point Float, typename Predicate>
+UInt64 CompressionCodecFPC::decompressCountIf(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size,
+    Predicate&& predicate) const {
+    UInt64 count{0};
+    decompressForEach<Float>(source, source_size, uncompressed_size, [&](std::span<const Float> values) {
+        for (auto value : values)
+            count += predicate(value) ? 1 : 0;
+    });
+    return count;
+}
+
+template <std::floating_point Float, typename Predicate>
+UInt64 CompressionCodecFPC::decompressSelect(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size,
+    Predicate&& predicate,
+    UInt64* bitmap) const {
+    // Only the last chunk may be shorter, so every other chunk fills whole bitmap words
+    static_assert(FPCOperation<UInt64>::CHUNK_SIZE % 64 == 0 && FPCOperation<UInt32>::CHUNK_SIZE % 64 == 0);
+
+    UInt64 count{0};
+    std::size_t word{0};
+    decompressForEach<Float>(source, source_size, uncompressed_size, [&](std::span<const Float> values) {
+        for (std::size_t begin = 0; begin < values.size(); begin += 64) {
+            auto group = values.subspan(begin, std::min<std::size_t>(64, values.size() - begin));
+            UInt64 bits{0};
+            for (std::size_t i = 0; i < group.size(); ++i)
+                bits |= static_cast<UInt64>(predicate(group[i]) ? 1 : 0) << i;
+            bitmap[word++] = bits;
+            count += static_cast<UInt64>(std::popcount(bits));
+        }
+    });
+    return count;
+}
+
+template <std::floating_point Float>
+UInt64 CompressionCodecFPC::decompressFilter(
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size,
+    Comparison comparison,
+    Float constant,
+    UInt64* bitmap) const {
+    auto select = [&](auto&& predicate) {
+        return decompressSelect<Float>(source, source_size, uncompressed_size, predicate, bitmap);
+    };
+    switch (comparison) {
+        case Comparison::Less:
+            return select([constant](Float value) { return value < constant; });
+        case Comparison::LessOrEquals:
+            return select([constant](Float value) { return value <= constant; });
+        case Comparison::Greater:
+            return select([constant](Float value) { return value > constant; });
+        case Comparison::GreaterOrEquals:
+            return select([constant](Float value) { return value >= constant; });
+        case Comparison::Equals:
+            return select([constant](Float value) { return value == constant; });
+        case Comparison::NotEquals:
+            return select([constant](Float value) { return value != constant; });
+    }
+    throw Exception("Unknown comparison", ErrorCodes::BAD_ARGUMENTS);
+}
+
+namespace {
+
+constexpr std::array<char, 4> FRAME_MAGIC{'F', 'P', 'C', 'F'};
+constexpr std::size_t FRAME_BLOCK_PREFIX_SIZE{sizeof(UInt32)};
+
+// Frame header layout: magic, float width, level, endianness, checksum flags, block size, uncompressed size
+struct FrameHeader {
+    UInt8 float_width;
+    UInt8 level;
+    UInt8 endianness;
+    FrameChecksum checksum;
+    UInt32 block_size;
+    UInt64 uncompressed_size;
+};
+
+void writeFrameHeader(std::span<std::byte> dest, const FrameHeader& header) {
+    std::memcpy(dest.data(), FRAME_MAGIC.data(), FRAME_MAGIC.size());
+    dest[4] = static_cast<std::byte>(header.float_width);
+    dest[5] = static_cast<std::byte>(header.level);
+    dest[6] = static_cast<std::byte>(header.endianness);
+    dest[7] = static_cast<std::byte>(header.checksum);
+    std::memcpy(dest.data() + 8, &header.block_size, sizeof(header.block_size));
+    std::memcpy(dest.data() + 12, &header.uncompressed_size, sizeof(header.uncompressed_size));
+}
+
+FrameHeader readFrameHeader(std::span<const std::byte> source) {
+    if (source.size() < CompressionCodecFPC::FRAME_HEADER_SIZE
+        || std::memcmp(source.data(), FRAME_MAGIC.data(), FRAME_MAGIC.size()) != 0)
+        throw Exception("Cannot decompress. Frame has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+
+    FrameHeader header{};
+    header.float_width = static_cast<UInt8>(source[4]);
+    header.level = static_cast<UInt8>(source[5]);
+    header.endianness = static_cast<UInt8>(source[6]);
+    header.checksum = static_cast<FrameChecksum>(source[7]);
+    std::memcpy(&header.block_size, source.data() + 8, sizeof(header.block_size));
+    std::memcpy(&header.uncompressed_size, source.data() + 12, sizeof(header.uncompressed_size));
+    if (static_cast<UInt8>(header.checksum) > static_cast<UInt8>(FrameChecksum::Both))
+        throw Exception("Cannot decompress. Frame has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+    // Block sizes are the ones getFrameBlockSize accepts, values never straddle blocks
+    if ((header.float_width != sizeof(Float64) && header.float_width != sizeof(Float32)) || header.block_size == 0
+        || header.block_size % header.float_width != 0 || header.block_size > CompressionCodecFPC::MAX_FRAME_BLOCK_SIZE)
+        throw Exception("Cannot decompress. Frame has incorrect block size", ErrorCodes::CANNOT_DECOMPRESS);
+    return header;
+}
+
+void checkFrameChecksum(FrameChecksum checksum) {
+    if (static_cast<UInt8>(checksum) > static_cast<UInt8>(FrameChecksum::Both))
+        throw Exception("Unknown frame checksum", ErrorCodes::BAD_ARGUMENTS);
+}
+
+std::size_t frameChecksumSize(FrameChecksum checksum) {
+    return static_cast<std::size_t>(std::popcount(static_cast<unsigned>(checksum))) * sizeof(UInt64);
+}
+
+UInt64 getMaxFrameBlockSize(UInt64 uncompressed_size, UInt8 float_width) {
+    return FRAME_BLOCK_PREFIX_SIZE + getMaxPayloadSize(uncompressed_size, float_width) + 2 * sizeof(UInt64);
+}
+
+// Calls func(state, i) for every i below count on up to threads threads, each thread with its own make_state()
+template <typename MakeState, typename Func>
+void parallelFor(std::size_t count, unsigned threads, MakeState&& make_state, Func&& func) {
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::once_flag error_once;
+    auto worker = [&] {
+        try {
+            auto state = make_state();
+            for (auto i = next++; i < count; i = next++)
+                func(state, i);
+        } catch (...) {
+            std::call_once(error_once, [&] { error = std::current_exception(); });
+            next = count;
+        }
+    };
+
+    std::vector<std::jthread> pool;
+    for (std::size_t i = 1; i < std::min<std::size_t>(threads, count); ++i)
+        pool.emplace_back(worker);
+    worker();
+    pool.clear();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// Block layout: UInt32 payload size, FPCOperation output, compressed and uncompressed checksums when enabled
+template <std::unsigned_integral TUint>
+std::size_t compressFrameBlock(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    FrameOperation<TUint>& operation,
+    FrameChecksum frame_checksum) {
+    operation.reset(dest.subspan(FRAME_BLOCK_PREFIX_SIZE), BlockChecksum{frame_checksum});
+    auto payload_size = static_cast<UInt32>(operation.encodeMore(source));
+    std::memcpy(dest.data(), &payload_size, sizeof(payload_size));
+
+    auto position = FRAME_BLOCK_PREFIX_SIZE + payload_size;
+    const auto& checksum = operation.chunkChecksum();
+    if (checksum.hasCompressed()) {
+        auto digest = checksum.compressedDigest();
+        std::memcpy(dest.data() + position, &digest, sizeof(digest));
+        position += sizeof(digest);
+    }
+    if (checksum.hasUncompressed()) {
+        auto digest = checksum.uncompressedDigest();
+        std::memcpy(dest.data() + position, &digest, sizeof(digest));
+        position += sizeof(digest);
+    }
+    return position;
+}
+
+// Returns the number of consumed bytes of source
+template <std::unsigned_integral TUint>
+std::size_t decompressFrameBlock(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    FrameOperation<TUint>& operation,
+    FrameChecksum frame_checksum) {
+    UInt32 payload_size{0};
+    if (source.size() < FRAME_BLOCK_PREFIX_SIZE)
+        throw Exception("Cannot decompress. Unexpected end of frame", ErrorCodes::CANNOT_DECOMPRESS);
+    std::memcpy(&payload_size, source.data(), sizeof(payload_size));
+    auto block_size = FRAME_BLOCK_PREFIX_SIZE + payload_size + frameChecksumSize(frame_checksum);
+    if (source.size() < block_size)
+        throw Exception("Cannot decompress. Unexpected end of frame", ErrorCodes::CANNOT_DECOMPRESS);
+
+    operation.reset(dest, BlockChecksum{frame_checksum});
+    auto read_bytes = std::move(operation).decode(source.subspan(FRAME_BLOCK_PREFIX_SIZE, payload_size), dest.size());
+    if (read_bytes != payload_size)
+        throw Exception("Cannot decompress. Frame block has wrong size", ErrorCodes::CANNOT_DECOMPRESS);
+
+    auto position = FRAME_BLOCK_PREFIX_SIZE + payload_size;
+    const auto& checksum = operation.chunkChecksum();
+    UInt64 digest{0};
+    if (checksum.hasCompressed()) {
+        std::memcpy(&digest, source.data() + position, sizeof(digest));
+        if (digest != checksum.compressedDigest())
+            throw Exception("Cannot decompress. Compressed checksum mismatch", ErrorCodes::CANNOT_DECOMPRESS);
+        position += sizeof(digest);
+    }
+    if (checksum.hasUncompressed()) {
+        std::memcpy(&digest, source.data() + position, sizeof(digest));
+        if (digest != checksum.uncompressedDigest())
+            throw Exception("Cannot decompress. Uncompressed checksum mismatch", ErrorCodes::CANNOT_DECOMPRESS);
+        position += sizeof(digest);
+    }
+    return position;
+}
+
+template <std::unsigned_integral TUint>
+std::size_t compressFrame(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    const FrameHeader& header,
+    std::pmr::memory_resource* resource,
+    unsigned threads) {
+    auto block_count = (source.size() + header.block_size - 1) / header.block_size;
+    auto block = [&](std::size_t i) {
+        return source.subspan(i * header.block_size, std::min<std::size_t>(header.block_size, source.size() - i * header.block_size));
+    };
+
+    const auto& kernels = dispatchedKernels().table<TUint>();
+    auto make_operation = [&] {
+        return FrameOperation<TUint>({}, header.level, resource, BlockChecksum{header.checksum});
+    };
+    std::size_t position{CompressionCodecFPC::FRAME_HEADER_SIZE};
+    if (threads <= 1 || block_count <= 1) {
+        auto operation = make_operation();
+        for (std::size_t i = 0; i < block_count; ++i)
+            position += kernels.compress_block(block(i), dest.subspan(position), operation, header.checksum);
+        return position;
+    }
+
+    // Blocks are compressed in parallel into worst-case sized slots, which is the layout
+    // getMaxCompressedFrameSize reserves, and then compacted in order
+    auto slot_size = getMaxFrameBlockSize(header.block_size, sizeof(TUint));
+    std::vector<std::size_t> block_sizes(block_count);
+    parallelFor(block_count, threads, make_operation, [&](FrameOperation<TUint>& operation, std::size_t i) {
+        auto slot = dest.subspan(CompressionCodecFPC::FRAME_HEADER_SIZE + i * slot_size);
+        block_sizes[i] = kernels.compress_block(block(i), slot, operation, header.checksum);
+    });
+    for (std::size_t i = 0; i < block_count; ++i) {
+        auto* slot = dest.data() + CompressionCodecFPC::FRAME_HEADER_SIZE + i * slot_size;
+        if (dest.data() + position != slot)
+            std::memmove(dest.data() + position, slot, block_sizes[i]);
+        position += block_sizes[i];
+    }
+    return position;
+}
+
+template <std::unsigned_integral TUint>
+void compressFrameBlocks(
+    std::span<FrameBlockTask> tasks,
+    UInt8 level,
+    FrameChecksum checksum,
+    std::pmr::memory_resource* resource,
+    unsigned threads) {
+    const auto& kernels = dispatchedKernels().table<TUint>();
+    auto make_operation = [&] {
+        return FrameOperation<TUint>({}, level, resource, BlockChecksum{checksum});
+    };
+    parallelFor(tasks.size(), threads, make_operation, [&](FrameOperation<TUint>& operation, std::size_t i) {
+        auto& task = tasks[i];
+        auto source = std::as_bytes(std::span(task.source, task.source_size));
+        auto dest = std::as_writable_bytes(std::span(task.dest, getMaxFrameBlockSize(task.source_size, sizeof(TUint))));
+        task.compressed_size = static_cast<UInt32>(kernels.compress_block(source, dest, operation, checksum));
+    });
+}
+
+template <std::unsigned_integral TUint>
+void decompressFrame(
+    std::span<const std::byte> source,
+    std::span<std::byte> dest,
+    const FrameHeader& header,
+    std::pmr::memory_resource* resource,
+    unsigned threads) {
+    // Block boundaries are found by hopping over the size prefixes, then blocks are decoded independently
+    auto block_count = (dest.size() + header.block_size - 1) / header.block_size;
+    if (block_count > (source.size() - CompressionCodecFPC::FRAME_HEADER_SIZE) / FRAME_BLOCK_PREFIX_SIZE)
+        throw Exception("Cannot decompress. Unexpected end of frame", ErrorCodes::CANNOT_DECOMPRESS);
+    std::vector<std::size_t> offsets(block_count + 1, CompressionCodecFPC::FRAME_HEADER_SIZE);
+    for (std::size_t i = 0; i < block_count; ++i) {
+        UInt32 payload_size{0};
+        if (source.size() - offsets[i] < FRAME_BLOCK_PREFIX_SIZE)
+            throw Exception("Cannot decompress. Unexpected end of frame", ErrorCodes::CANNOT_DECOMPRESS);
+        std::memcpy(&payload_size, source.data() + offsets[i], sizeof(payload_size));
+        offsets[i + 1] = offsets[i] + FRAME_BLOCK_PREFIX_SIZE + payload_size + frameChecksumSize(header.checksum);
+        if (offsets[i + 1] > source.size())
+            throw Exception("Cannot decompress. Unexpected end of frame", ErrorCodes::CANNOT_DECOMPRESS);
+    }
+    if (offsets.back() != source.size())
+        throw Exception("Cannot decompress. Frame has trailing data", ErrorCodes::CANNOT_DECOMPRESS);
+
+    const auto& kernels = dispatchedKernels().table<TUint>();
+    auto make_operation = [&] {
+        return FrameOperation<TUint>({}, header.level, resource, BlockChecksum{header.checksum});
+    };
+    parallelFor(block_count, threads, make_operation, [&](FrameOperation<TUint>& operation, std::size_t i) {
+        auto offset = i * header.block_size;
+        kernels.decompress_block(
+            source.subspan(offsets[i], offsets[i + 1] - offsets[i]),
+            dest.subspan(offset, std::min<std::size_t>(header.block_size, dest.size() - offset)),
+            operation, header.checksum);
+    });
+}
+
+}
+
+UInt32 CompressionCodecFPC::getFrameBlockSize(UInt32 block_size) const {
+    if (block_size == 0) {
+        auto tables_size = 2 * (UInt64{1} << level) * float_width;
+        return static_cast<UInt32>(std::clamp<UInt64>(tables_size, FRAME_BLOCK_SIZE, MAX_FRAME_BLOCK_SIZE));
+    }
+    if (block_size % float_width != 0 || block_size > MAX_FRAME_BLOCK_SIZE)
+        throw Exception("Frame block size must be a multiple of float width up to 1 GiB", ErrorCodes::BAD_ARGUMENTS);
+    return block_size;
+}
+
+UInt64 CompressionCodecFPC::getMaxCompressedFrameSize(UInt64 uncompressed_size, UInt32 block_size) const {
+    block_size = getFrameBlockSize(block_size);
+    auto full_blocks = uncompressed_size / block_size;
+    auto last_block = uncompressed_size % block_size;
+    auto size = FRAME_HEADER_SIZE + full_blocks * getMaxFrameBlockSize(block_size, float_width);
+    if (last_block != 0)
+        size += getMaxFrameBlockSize(last_block, float_width);
+    return size;
+}
+
+UInt32 CompressionCodecFPC::getMaxCompressedFrameBlockSize(UInt32 block_size) const {
+    return static_cast<UInt32>(getMaxFrameBlockSize(block_size, float_width));
+}
+
+UInt32 CompressionCodecFPC::doCompressFrameHeader(
+    UInt64 source_size,
+    char* dest,
+    FrameChecksum checksum,
+    UInt32 block_size) const {
+    checkFrameChecksum(checksum);
+    FrameHeader header{
+        float_width, level, encodeEndianness(std::endian::native), checksum, getFrameBlockSize(block_size), source_size};
+    writeFrameHeader(std::as_writable_bytes(std::span(dest, FRAME_HEADER_SIZE)), header);
+    return FRAME_HEADER_SIZE;
+}
+
+void CompressionCodecFPC::doCompressFrameBlocks(
+    std::span<FrameBlockTask> tasks,
+    FrameChecksum checksum,
+    unsigned threads) const {
+    checkFrameChecksum(checksum);
+    switch (float_width) {
+        case sizeof(Float64):
+            compressFrameBlocks<UInt64>(tasks, level, checksum, memory_resource, threads);
+            return;
+        case sizeof(Float32):
+            compressFrameBlocks<UInt32>(tasks, level, checksum, memory_resource, threads);
+            return;
+        default:
+            break;
+    }
+    throw Exception("Cannot compress. Incorrect float width", ErrorCodes::CANNOT_COMPRESS);
+}
+
+UInt64 CompressionCodecFPC::getFrameUncompressedSize(const char* source, UInt64 source_size) {
+    return readFrameHeader(std::as_bytes(std::span(source, source_size))).uncompressed_size;
+}
+
+UInt64 CompressionCodecFPC::doCompressFrame(
+    const char* source,
+    UInt64 source_size,
+    char* dest,
+    FrameChecksum checksum,
+    unsigned threads,
+    UInt32 block_size) const {
+    checkFrameChecksum(checksum);
+    block_size = getFrameBlockSize(block_size);
+    FrameHeader header{float_width, level, encodeEndianness(std::endian::native), checksum, block_size, source_size};
+    auto destination = std::as_writable_bytes(std::span(dest, getMaxCompressedFrameSize(source_size, block_size)));
+    writeFrameHeader(destination, header);
+
+    auto src = std::as_bytes(std::span(source, source_size));
+    switch (float_width) {
+        case sizeof(Float64):
+            return compressFrame<UInt64>(src, destination, header, memory_resource, threads);
+        case sizeof(Float32):
+            return compressFrame<UInt32>(src, destination, header, memory_resource, threads);
+        default:
+            break;
+    }
+    throw Exception("Cannot compress. Incorrect float width", ErrorCodes::CANNOT_COMPRESS);
+}
+
+void CompressionCodecFPC::doDecompressFrame(
+    const char* source,
+    UInt64 source_size,
+    char* dest,
+    UInt64 uncompressed_size,
+    unsigned threads) const {
+    auto src = std::as_bytes(std::span(source, source_size));
+    auto header = readFrameHeader(src);
+    if (header.float_width != float_width)
+        throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+    if (header.level != level)
+        throw Exception("Cannot decompress. File has incorrect compression level", ErrorCodes::CANNOT_DECOMPRESS);
+    if (decodeEndianness(header.endianness) != std::endian::native)
+        throw Exception("Cannot decompress. File has incorrect endianness", ErrorCodes::CANNOT_DECOMPRESS);
+    if (header.uncompressed_size != uncompressed_size)
+        throw Exception("Cannot decompress. Frame has incorrect uncompressed size", ErrorCodes::CANNOT_DECOMPRESS);
+
+    auto destination = std::as_writable_bytes(std::span(dest, uncompressed_size));
+    switch (float_width) {
+        case sizeof(Float64):
+            decompressFrame<UInt64>(src, destination, header, memory_resource, threads);
+            break;
+        case sizeof(Float32):
+            decompressFrame<UInt32>(src, destination, header, memory_resource, threads);
+            break;
+        default:
+            break;
+    }
+}
+
+CompressionCodecFPCInteger::CompressionCodecFPCInteger(
+    UInt8 integer_size,
+    UInt8 compression_level,
+    IntegerTransform integer_transform,
+    std::pmr::memory_resource* resource)
+    : integer_width{integer_size}, level{compression_level}, transform{integer_transform}, memory_resource{resource}
+{
+    if (integer_width != sizeof(UInt64) && integer_width != sizeof(UInt32))
+        throw Exception("Incorrect integer width", ErrorCodes::ILLEGAL_CODEC_PARAMETER);
+    if (transform > IntegerTransform::DeltaOfDelta)
+        throw Exception("Unknown integer transform", ErrorCodes::ILLEGAL_CODEC_PARAMETER);
+    checkCompressionLevel(level);
+}
+
+UInt32 CompressionCodecFPCInteger::getMaxCompressedDataSize(UInt32 uncompressed_size) const {
+    auto max_size = HEADER_SIZE + getMaxPayloadSize(uncompressed_size, integer_width);
+    if (max_size > std::numeric_limits<UInt32>::max())
+        throw Exception("Cannot compress. Data is too large", ErrorCodes::CANNOT_COMPRESS);
+    return static_cast<UInt32>(max_size);
+}
+
+UInt32 CompressionCodecFPCInteger::doCompressData(const char* source, UInt32 source_size, char* dest) const {
+    if (source_size % integer_width != 0)
+        throw Exception("Cannot compress. Data must hold whole integers", ErrorCodes::BAD_ARGUMENTS);
+
+    dest[0] = static_cast<char>(integer_width);
+    dest[1] = static_cast<char>(level);
+    dest[2] = static_cast<char>(encodeEndianness(std::endian::native) | INTEGER_HEADER_FLAG);
+    dest[3] = static_cast<char>(transform);
+
+    auto src = std::as_bytes(std::span(source, source_size));
+    auto destination = std::as_writable_bytes(
+        std::span(dest, getMaxCompressedDataSize(source_size)).subspan(HEADER_SIZE));
+    auto payload_size = integer_width == sizeof(UInt64)
+        ? dispatchedKernels().table<UInt64>().encode_integers(src, destination, level, transform, memory_resource)
+        : dispatchedKernels().table<UInt32>().encode_integers(src, destination, level, transform, memory_resource);
+    return HEADER_SIZE + static_cast<UInt32>(payload_size);
+}
+
+void CompressionCodecFPCInteger::doDecompressData(
+    const char* source,
+    UInt32 source_size,
+    char* dest,
+    UInt32 uncompressed_size) const {
+    if (source_size < HEADER_SIZE)
+        throw Exception("Cannot decompress. File has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+    if (uncompressed_size % integer_width != 0)
+        throw Exception("Cannot decompress. Data must hold whole integers", ErrorCodes::BAD_ARGUMENTS);
+
+    auto compressed_data = std::span(source, source_size);
+    auto flags = static_cast<UInt8>(compressed_data[2]);
+    if (static_cast<UInt8>(compressed_data[0]) != integer_width)
+        throw Exception("Cannot decompress. File has incorrect integer width", ErrorCodes::CANNOT_DECOMPRESS);
+    if (static_cast<UInt8>(compressed_data[1]) != level)
+        throw Exception("Cannot decompress. File has incorrect compression level", ErrorCodes::CANNOT_DECOMPRESS);
+    if ((flags & INTEGER_HEADER_FLAG) == 0)
+        throw Exception("Cannot decompress. File holds floats", ErrorCodes::CANNOT_DECOMPRESS);
+    if (decodeEndianness(static_cast<UInt8>(flags & ~INTEGER_HEADER_FLAG)) != std::endian::native)
+        throw Exception("Cannot decompress. File has incorrect endianness", ErrorCodes::CANNOT_DECOMPRESS);
+    if (static_cast<IntegerTransform>(compressed_data[3]) != transform)
+        throw Exception("Cannot decompress. File has incorrect integer transform", ErrorCodes::CANNOT_DECOMPRESS);
+
+    auto src = std::as_bytes(compressed_data.subspan(HEADER_SIZE));
+    auto destination = std::as_writable_bytes(std::span(dest, uncompressed_size));
+    if (integer_width == sizeof(UInt64))
+        dispatchedKernels().table<UInt64>().decode_integers(src, destination, level, transform, memory_resource);
+    else
+        dispatchedKernels().table<UInt32>().decode_integers(src, destination, level, transform, memory_resource);
+}
+
+std::optional<CompressionCodecFPC::EncodedBlock> CompressionCodecFPC::chooseBlockEncoding(
+    std::span<const std::byte> source) const {
+    if (float_width != sizeof(Float64) || predictor_snapshot != nullptr || source.empty()
+        || source.size() % sizeof(Float64) != 0)
+        return std::nullopt;
+
+    if (block_encodings & BlockEncodings::Decimal) {
+        if (auto exponent = findDecimalExponent(source))
+            return EncodedBlock{DECIMAL_HEADER_FLAG, static_cast<UInt8>(*exponent), source};
+    }
+    if ((block_encodings & BlockEncodings::Downcast) && isExactFloat32(source))
+        return EncodedBlock{DOWNCAST_HEADER_FLAG, 0, source};
+    return std::nullopt;
+}
+
+template <typename Statistics>
+UInt32 CompressionCodecFPC::compressEncodedBlock(const EncodedBlock& block, char* dest, Statistics& statistics) const {
+    writeHeader(dest);
+    dest[2] = static_cast<char>(dest[2] | block.flag);
+    auto header_size = encodedBlockHeaderSize(block.flag);
+    if (block.flag == DECIMAL_HEADER_FLAG)
+        dest[HEADER_SIZE] = static_cast<char>(block.exponent);
+
+    auto destination = std::as_writable_bytes(
+        std::span(dest, getMaxCompressedDataSize(static_cast<UInt32>(block.values.size()))).subspan(header_size));
+    std::size_t payload_size{0};
+    if constexpr (std::is_same_v<Statistics, NoEncoderStatistics>) {
+        const auto& kernels = dispatchedKernels().block_encodings;
+        payload_size = block.flag == DECIMAL_HEADER_FLAG
+            ? kernels.encode_decimal(block.values, destination, level, block.exponent, memory_resource)
+            : kernels.encode_downcast(block.values, destination, level, memory_resource);
+    } else {
+        payload_size = block.flag == DECIMAL_HEADER_FLAG
+            ? encodeDecimal(block.values, destination, level, block.exponent, memory_resource, statistics)
+            : encodeDowncast(block.values, destination, level, memory_resource, statistics);
+    }
+    return header_size + static_cast<UInt32>(payload_size);
+}
+
+std::optional<CompressionCodecFPC::EncodedBlock> CompressionCodecFPC::encodedBlock(
+    const char* source,
+    UInt32 source_size) const {
+    if (source_size < HEADER_SIZE || (static_cast<UInt8>(source[2]) & BLOCK_ENCODING_HEADER_FLAGS) == 0)
+        return std::nullopt;
+
+    auto flag = (static_cast<UInt8>(source[2]) & DECIMAL_HEADER_FLAG) != 0 ? DECIMAL_HEADER_FLAG : DOWNCAST_HEADER_FLAG;
+    if (static_cast<UInt8>(source[0]) != float_width || float_width != sizeof(Float64))
+        throw Exception("Cannot decompress. File has incorrect float width", ErrorCodes::CANNOT_DECOMPRESS);
+    if (static_cast<UInt8>(source[1]) != level)
+        throw Exception("Cannot decompress. File has incorrect compression level", ErrorCodes::CANNOT_DECOMPRESS);
+    if (decodeEndianness(static_cast<UInt8>(source[2] & ~flag)) != std::endian::native)
+        throw Exception("Cannot decompress. File has incorrect endianness", ErrorCodes::CANNOT_DECOMPRESS);
+    if (predictor_snapshot != nullptr)
+        throw Exception("Cannot decompress. File and codec disagree on predictor snapshot", ErrorCodes::CANNOT_DECOMPRESS);
+
+    auto header_size = encodedBlockHeaderSize(flag);
+    if (source_size < header_size)
+        throw Exception("Cannot decompress. File has wrong header", ErrorCodes::CANNOT_DECOMPRESS);
+    UInt8 exponent{0};
+    if (flag == DECIMAL_HEADER_FLAG) {
+        exponent = static_cast<UInt8>(source[HEADER_SIZE]);
+        if (exponent > MAX_DECIMAL_EXPONENT)
+            throw Exception("Cannot decompress. File has incorrect decimal exponent", ErrorCodes::CANNOT_DECOMPRESS);
+    }
+    return EncodedBlock{flag, exponent, std::as_bytes(std::span(source, source_size).subspan(header_size))};
+}
+
 }
@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "fpc_codec.h"
+#include "datasets.h"
+
+namespace {
+
+template <typename Float>
+void Encode(benchmark::State& state) {
+    auto level = static_cast<UInt8>(state.range(0));
+    auto bytes = static_cast<std::size_t>(state.range(1));
+    auto inp = GenTest<Float>(bytes, static_cast<Distribution>(state.range(2)));
+    bytes = inp.size() * sizeof(Float);
+
+    DB::CompressionCodecFPC codec(sizeof(Float), level);
+    std::vector<char> encoded(codec.getMaxCompressedDataSize(bytes));
+    UInt32 compressed{0};
+    for (auto _ : state) {
+        compressed = codec.doCompressData(reinterpret_cast<const char*>(inp.data()), bytes, encoded.data());
+        benchmark::DoNotOptimize(encoded.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    state.counters["ratio"] = static_cast<double>(bytes) / compressed;
+}
+
+template <typename Float>
+void Decode(benchmark::State& state) {
+    auto level = static_cast<UInt8>(state.range(0));
+    auto bytes = static_cast<std::size_t>(state.range(1));
+    auto inp = GenTest<Float>(bytes, static_cast<Distribution>(state.range(2)));
+    bytes = inp.size() * sizeof(Float);
+
+    DB::CompressionCodecFPC codec(sizeof(Float), level);
+    std::vector<char> encoded(codec.getMaxCompressedDataSize(bytes));
+    auto compressed = codec.doCompressData(reinterpret_cast<const char*>(inp.data()), bytes, encoded.data());
+    std::vector<Float> decoded(inp.size());
+    for (auto _ : state) {
+        codec.doDecompressData(encoded.data(), compressed, reinterpret_cast<char*>(decoded.data()), bytes);
+        benchmark::DoNotOptimize(decoded.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    state.counters["ratio"] = static_cast<double>(bytes) / compressed;
+}
+
+// Decompression into a buffer followed by a second pass, the baseline for DecodeSum
+template <typename Float>
+void DecodeThenSum(benchmark::State& state) {
+    auto level = static_cast<UInt8>(state.range(0));
+    auto bytes = static_cast<std::size_t>(state.range(1));
+    auto inp = GenTest<Float>(bytes, static_cast<Distribution>(state.range(2)));
+    bytes = inp.size() * sizeof(Float);
+
+    DB::CompressionCodecFPC codec(sizeof(Float), level);
+    std::vector<char> encoded(codec.getMaxCompressedDataSize(bytes));
+    auto compressed = codec.doCompressData(reinterpret_cast<const char*>(inp.data()), bytes, encoded.data());
+    std::vector<Float> decoded(inp.size());
+    for (auto _ : state) {
+        codec.doDecompressData(encoded.data(), compressed, reinterpret_cast<char*>(decoded.data()), bytes);
+        Float64 sum{0};
+        for (auto value : decoded)
+            sum += value;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+}
+
+template <typename Float>
+void DecodeSum(benchmark::State& state) {
+    auto level = static_cast<UInt8>(state.range(0));
+    auto bytes = static_cast<std::size_t>(state.range(1));
+    auto inp = GenTest<Float>(bytes, static_cast<Distribution>(state.range(2)));
+    bytes = inp.size() * sizeof(Float);
+
+    DB::CompressionCodecFPC codec(sizeof(Float), level);
+    std::vector<char> encoded(codec.getMaxCompressedDataSize(bytes));
+    auto compressed = codec.doCompressData(reinterpret_cast<const char*>(inp.data()), bytes, encoded.data());
+    for (auto _ : state) {
+        auto sum = codec.decompressSum<Float>(encoded.data(), compressed, bytes);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+}
+
+template <std::size_t ChunkSize>
+void EncodeChunk(benchmark::State& state) {
+    auto level = static_cast<UInt8>(state.range(0));
+    auto bytes = static_cast<std::size_t>(state.range(1));
+    auto inp = GenTest<Float64>(bytes, static_cast<Distribution>(state.range(2)));
+    auto src = std::as_bytes(std::span(inp));
+
+    std::vector<std::byte> encoded(DB::CompressionCodecFPC(sizeof(Float64), level).getMaxCompressedDataSize(bytes));
+    for (auto _ : state) {
+        auto compressed = DB::FPCOperation<UInt64, std::endian::native, ChunkSize>(encoded, level).encode(src);
+        benchmark::DoNotOptimize(compressed);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * src.size()));
+}
+
+template <std::size_t ChunkSize>
+void DecodeChunk(benchmark::State& state) {
+    auto level = static_cast<UInt8>(state.range(0));
+    auto bytes = static_cast<std::size_t>(state.range(1));
+    auto inp = GenTest<Float64>(bytes, static_cast<Distribution>(state.range(2)));
+    auto src = std::as_bytes(std::span(inp));
+
+    std::vector<std::byte> encoded(DB::CompressionCodecFPC(sizeof(Float64), level).getMaxCompressedDataSize(bytes));
+    auto compressed = DB::FPCOperation<UInt64, std::endian::native, ChunkSize>(encoded, level).encode(src);
+    std::vector<Float64> decoded(inp.size());
+    for (auto _ : state) {
+        DB::FPCOperation<UInt64, std::endian::native, ChunkSize>(std::as_writable_bytes(std::span(decoded)), level)
+            .decode(std::span(encoded).first(compressed), src.size());
+        benchmark::DoNotOptimize(decoded.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * src.size()));
+}
+
+// Input sizes are chosen to fit L1, L2, L3 and to spill to DRAM respectively
+const std::vector<std::int64_t> SIZES{16 << 10, 256 << 10, 4 << 20, 64 << 20};
+const std::vector<std::int64_t> DISTRIBUTION_ARGS{
+    static_cast<std::int64_t>(Distribution::Uniform),
+    static_cast<std::int64_t>(Distribution::RandomWalk)};
+
+void LevelArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"level", "bytes", "dist"})->ArgsProduct({{8, 12, 16, 20}, SIZES, DISTRIBUTION_ARGS});
+}
+
+void ChunkArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"level", "bytes", "dist"})->ArgsProduct({{12}, SIZES, DISTRIBUTION_ARGS});
+}
+
+}
+
+BENCHMARK_TEMPLATE(Encode, Float64)->Apply(LevelArgs);
+BENCHMARK_TEMPLATE(Decode, Float64)->Apply(LevelArgs);
+BENCHMARK_TEMPLATE(Encode, Float32)->Apply(LevelArgs);
+BENCHMARK_TEMPLATE(Decode, Float32)->Apply(LevelArgs);
+
+BENCHMARK_TEMPLATE(DecodeThenSum, Float64)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(DecodeSum, Float64)->Apply(ChunkArgs);
+
+BENCHMARK_TEMPLATE(EncodeChunk, 16)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(DecodeChunk, 16)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(EncodeChunk, 32)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(DecodeChunk, 32)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(EncodeChunk, 64)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(DecodeChunk, 64)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(EncodeChunk, 128)->Apply(ChunkArgs);
+BENCHMARK_TEMPLATE(DecodeChunk, 128)->Apply(ChunkArgs);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::AddCustomContext("fpc_codec_isa", std::string(DB::CompressionCodecFPC::getDispatchedIsa()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
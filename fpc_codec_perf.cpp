@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+#include "fpc_codec.h"
+#include "datasets.h"
+#include "perf_counters.h"
+
+namespace {
+
+constexpr std::array LEVELS{8, 12, 16, 20};
+constexpr int REPETITIONS{5};
+
+void PrintMetric(std::optional<double> value, double divisor) {
+    if (value)
+        std::printf(" %10.3f", *value / divisor);
+    else
+        std::printf(" %10s", "n/a");
+}
+
+void PrintRow(const char* operation, Distribution distribution, std::size_t width, int level,
+              const PerfCounters::Sample& sample, double values) {
+    std::printf("%-6s %-12s %5zu %5d", operation, DistributionName(distribution).data(), width, level);
+    PrintMetric(sample[PerfCounters::Cycles], values);
+    if (sample[PerfCounters::Cycles] && sample[PerfCounters::Instructions])
+        std::printf(" %10.3f", *sample[PerfCounters::Instructions] / *sample[PerfCounters::Cycles]);
+    else
+        std::printf(" %10s", "n/a");
+    PrintMetric(sample[PerfCounters::BranchMisses], values);
+    PrintMetric(sample[PerfCounters::L1DMisses], values);
+    PrintMetric(sample[PerfCounters::LLCMisses], values);
+    std::puts("");
+}
+
+// Keeps the repetition with the fewest cycles to filter out interference from the rest of the system
+template <typename Func>
+PerfCounters::Sample Measure(PerfCounters& counters, Func&& func) {
+    PerfCounters::Sample best;
+    for (int i = 0; i < REPETITIONS; ++i) {
+        counters.start();
+        func();
+        auto sample = counters.stop();
+        if (!best[PerfCounters::Cycles]
+            || (sample[PerfCounters::Cycles] && *sample[PerfCounters::Cycles] < *best[PerfCounters::Cycles]))
+            best = sample;
+    }
+    return best;
+}
+
+template <typename Float>
+void PerfTest(PerfCounters& counters, std::size_t bytes) {
+    for (auto distribution : DISTRIBUTIONS) {
+        auto inp = GenTest<Float>(bytes, distribution);
+        auto source_size = static_cast<UInt32>(inp.size() * sizeof(Float));
+        auto values = static_cast<double>(inp.size());
+        std::vector<Float> decoded(inp.size());
+
+        for (auto level : LEVELS) {
+            DB::CompressionCodecFPC codec(sizeof(Float), static_cast<UInt8>(level));
+            std::vector<char> encoded(codec.getMaxCompressedDataSize(source_size));
+            UInt32 compressed{0};
+
+            auto encode = Measure(counters, [&] {
+                compressed = codec.doCompressData(reinterpret_cast<const char*>(inp.data()), source_size, encoded.data());
+            });
+            PrintRow("encode", distribution, sizeof(Float), level, encode, values);
+
+            auto decode = Measure(counters, [&] {
+                codec.doDecompressData(encoded.data(), compressed, reinterpret_cast<char*>(decoded.data()), source_size);
+            });
+            PrintRow("decode", distribution, sizeof(Float), level, decode, values);
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::span args(argv, argc);
+    std::size_t bytes = args.size() > 1 ? std::strtoull(args[1], nullptr, 10) : 16 << 20;
+
+    PerfCounters counters;
+    if (!counters.available())
+        std::fputs("perf_event_open is not permitted, check /proc/sys/kernel/perf_event_paranoid\n", stderr);
+
+    std::printf("%-6s %-12s %5s %5s %10s %10s %10s %10s %10s\n",
+                "op", "data", "width", "level", "cycles/v", "IPC", "brmiss/v", "L1Dmiss/v", "LLCmiss/v");
+    PerfTest<Float64>(counters, bytes);
+    PerfTest<Float32>(counters, bytes);
+    return 0;
+}
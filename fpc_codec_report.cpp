@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+#include "fpc_codec.h"
+#include "datasets.h"
+
+namespace {
+
+constexpr std::array LEVELS{8, 10, 12, 14, 16, 20};
+constexpr int REPETITIONS{3};
+
+template <typename Func>
+double BestSeconds(Func&& func) {
+    double best{std::numeric_limits<double>::max()};
+    for (int i = 0; i < REPETITIONS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto fin = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(fin - start).count());
+    }
+    return best;
+}
+
+template <typename Float>
+void Report(Distribution distribution, std::size_t bytes) {
+    auto inp = GenTest<Float>(bytes, distribution);
+    auto source_size = static_cast<UInt32>(inp.size() * sizeof(Float));
+    auto megabytes = static_cast<double>(source_size) / (1024 * 1024);
+    std::vector<Float> decoded(inp.size());
+
+    for (auto level : LEVELS) {
+        DB::CompressionCodecFPC codec(sizeof(Float), static_cast<UInt8>(level));
+        std::vector<char> encoded(codec.getMaxCompressedDataSize(source_size));
+        UInt32 compressed{0};
+
+        auto enc = BestSeconds([&] {
+            compressed = codec.doCompressData(reinterpret_cast<const char*>(inp.data()), source_size, encoded.data());
+        });
+        auto dec = BestSeconds([&] {
+            codec.doDecompressData(encoded.data(), compressed, reinterpret_cast<char*>(decoded.data()), source_size);
+        });
+        if (std::memcmp(decoded.data(), inp.data(), source_size) != 0) {
+            std::fprintf(stderr, "Round trip mismatch for %s\n", DistributionName(distribution).data());
+            std::exit(1);
+        }
+
+        std::printf("%-12s %5zu %5d %8.3f %10.1f %10.1f\n", DistributionName(distribution).data(), sizeof(Float),
+                    level, static_cast<double>(source_size) / compressed, megabytes / enc, megabytes / dec);
+    }
+}
+
+template <typename Float>
+void Dump(Distribution distribution, std::size_t bytes, const std::filesystem::path& directory) {
+    auto inp = GenTest<Float>(bytes, distribution);
+    auto path = directory / (std::string(DistributionName(distribution)) + ".f" + std::to_string(sizeof(Float) * 8));
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(inp.data()), static_cast<std::streamsize>(inp.size() * sizeof(Float)));
+    std::printf("%s\n", path.c_str());
+}
+
+}
+
+// Usage: fpc_codec_report [bytes] [--dump <directory>]
+// Prints compression ratio and encode/decode MB/s per corpus and level,
+// or writes the corpora to <directory> as raw little-endian arrays for use with other tools.
+int main(int argc, char* argv[]) {
+    std::span args(argv, argc);
+    std::size_t bytes{64 << 20};
+    std::filesystem::path dump_directory;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        if (std::strcmp(args[i], "--dump") == 0 && i + 1 < args.size())
+            dump_directory = args[++i];
+        else
+            bytes = std::strtoull(args[i], nullptr, 10);
+    }
+
+    if (!dump_directory.empty()) {
+        std::filesystem::create_directories(dump_directory);
+        for (auto distribution : DISTRIBUTIONS)
+            Dump<Float64>(distribution, bytes, dump_directory);
+        Dump<Float32>(Distribution::MLWeights, bytes, dump_directory);
+        return 0;
+    }
+
+    std::printf("%-12s %5s %5s %8s %10s %10s\n", "corpus", "width", "level", "ratio", "enc MB/s", "dec MB/s");
+    for (auto distribution : DISTRIBUTIONS)
+        Report<Float64>(distribution, bytes);
+    Report<Float32>(Distribution::MLWeights, bytes);
+    return 0;
+}
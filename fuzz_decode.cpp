@@ -0,0 +1,156 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "fpc_codec.h"
+
+namespace {
+
+constexpr UInt64 MAX_UNCOMPRESSED_SIZE{1 << 24};
+constexpr std::size_t MAX_ALLOCATION_SIZE{1 << 26};
+
+// Fails allocations of the predictor tables of the highest levels the way an exhausted allocator would,
+// so that every level is decoded without gigabytes of memory
+class BoundedResource : public std::pmr::memory_resource {
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes > MAX_ALLOCATION_SIZE)
+            throw std::bad_alloc();
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+BoundedResource bounded_resource;
+
+// Decoding of malformed input may only throw these
+template <typename Func>
+void Decode(Func&& func) {
+    try {
+        func();
+    } catch (const std::runtime_error&) {
+    } catch (const std::bad_alloc&) {
+    }
+}
+
+// Every entry point decoding a float stream, exact sized buffers let the address sanitizer catch any write
+// past the declared size
+template <typename Float>
+void FuzzFloatDecoders(
+    const DB::CompressionCodecFPC& codec,
+    const char* source,
+    UInt32 source_size,
+    UInt32 uncompressed_size) {
+    std::vector<char> dest(uncompressed_size);
+    Decode([&] { codec.doDecompressData(source, source_size, dest.data(), uncompressed_size); });
+
+    // A full group of identical streams takes the lockstep path of the batch decoder
+    std::vector<std::vector<char>> batch_dests(8, std::vector<char>(uncompressed_size));
+    std::vector<DB::DecompressionTask> tasks;
+    for (auto& batch_dest : batch_dests)
+        tasks.push_back({source, source_size, batch_dest.data(), uncompressed_size});
+    Decode([&] { codec.doDecompressBatch(tasks); });
+
+    auto count = uncompressed_size / static_cast<UInt32>(sizeof(Float));
+    std::vector<char> prefix(std::size_t{count} * sizeof(Float));
+    Decode([&] { codec.decompressPrefix(source, source_size, prefix.data(), count); });
+
+    // Every other value slot of an array of pairs, the buffer ends right after the last value
+    constexpr auto STRIDE = 2 * sizeof(Float);
+    std::vector<char> strided(count == 0 ? 0 : (count - 1) * STRIDE + sizeof(Float));
+    Decode([&] { codec.doDecompressStrided(source, source_size, strided.data(), STRIDE, count); });
+
+    Decode([&] {
+        Float sum{0};
+        for (auto value : codec.decodedView<Float>(source, source_size, uncompressed_size))
+            sum += value;
+    });
+}
+
+// Stream input: two bytes of uncompressed size followed by the codec output, header included.
+// Streams are decoded by the float and the integer codec of the width and level in their header.
+void FuzzStream(const std::uint8_t* data, std::size_t size) {
+    if (size < sizeof(std::uint16_t) + DB::CompressionCodecFPC::HEADER_SIZE)
+        return;
+    std::uint16_t uncompressed_size{0};
+    std::memcpy(&uncompressed_size, data, sizeof(uncompressed_size));
+    const auto* source = reinterpret_cast<const char*>(data + sizeof(uncompressed_size));
+    auto source_size = static_cast<UInt32>(size - sizeof(uncompressed_size));
+
+    auto width = static_cast<UInt8>(source[0]);
+    auto level = static_cast<UInt8>(source[1]);
+    std::optional<DB::CompressionCodecFPC> codec;
+    Decode([&] { codec.emplace(width, level, &bounded_resource); });
+    if (codec && width == sizeof(Float64))
+        FuzzFloatDecoders<Float64>(*codec, source, source_size, uncompressed_size);
+    else if (codec)
+        FuzzFloatDecoders<Float32>(*codec, source, source_size, uncompressed_size);
+
+    if (source_size < DB::CompressionCodecFPCInteger::HEADER_SIZE)
+        return;
+    Decode([&] {
+        auto transform = static_cast<DB::IntegerTransform>(source[3]);
+        DB::CompressionCodecFPCInteger integer_codec(width, level, transform, &bounded_resource);
+        std::vector<char> dest(uncompressed_size);
+        integer_codec.doDecompressData(source, source_size, dest.data(), uncompressed_size);
+    });
+}
+
+template <typename State>
+std::vector<char> Serialize(const State& state) {
+    std::vector<char> serialized(state.getSerializedSize());
+    state.serialize(serialized.data());
+    return serialized;
+}
+
+// Serialized states are either rejected or accepted with a serialization that reads back unchanged
+template <typename State>
+void FuzzState(const std::uint8_t* data, std::size_t size) {
+    Decode([&] {
+        auto serialized = Serialize(State::deserialize(reinterpret_cast<const char*>(data), size));
+        if (Serialize(State::deserialize(serialized.data(), serialized.size())) != serialized)
+            __builtin_trap();
+    });
+}
+
+void FuzzFrame(const std::uint8_t* data, std::size_t size) {
+    const auto* source = reinterpret_cast<const char*>(data);
+    Decode([&] {
+        auto uncompressed_size = DB::CompressionCodecFPC::getFrameUncompressedSize(source, size);
+        auto float_width = static_cast<UInt8>(source[4]);
+        auto level = static_cast<UInt8>(source[5]);
+        if (uncompressed_size > MAX_UNCOMPRESSED_SIZE)
+            return;
+
+        std::vector<char> dest(uncompressed_size);
+        DB::CompressionCodecFPC codec(float_width, level, &bounded_resource);
+        codec.doDecompressFrame(source, size, dest.data(), uncompressed_size);
+    });
+}
+
+}
+
+// libFuzzer entry point, decoding of arbitrary input must either succeed or throw
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    if (size >= 4 && std::memcmp(data, "FPCF", 4) == 0)
+        FuzzFrame(data, size);
+    else if (size >= 4 && std::memcmp(data, "FPCS", 4) == 0)
+        FuzzState<DB::PredictorSnapshot>(data, size);
+    else if (size >= 4 && std::memcmp(data, "FPCA", 4) == 0)
+        FuzzState<DB::AppendState>(data, size);
+    else
+        FuzzStream(data, size);
+    return 0;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef FPC_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+// Asynchronous positional reads and writes. Every request is identified by a caller-chosen tag,
+// wait() blocks until some request has been transferred completely and returns its tag.
+// Short transfers are resubmitted internally, errors are thrown from wait() as std::system_error.
+class IoQueue {
+public:
+    virtual ~IoQueue() = default;
+
+    virtual void read(int fd, char* buffer, std::size_t size, off_t offset, std::size_t tag) = 0;
+    virtual void write(int fd, const char* buffer, std::size_t size, off_t offset, std::size_t tag) = 0;
+    virtual std::size_t wait() = 0;
+
+    // Returns io_uring backed queue when it is compiled in and supported by the kernel, thread backed otherwise
+    static std::unique_ptr<IoQueue> create(unsigned depth);
+
+protected:
+    struct Request {
+        int fd;
+        bool is_write;
+        char* buffer;
+        std::size_t size;
+        off_t offset;
+        std::size_t tag;
+
+        // Advances the request by transferred bytes, returns true when it is complete
+        bool advance(std::size_t transferred) noexcept {
+            buffer += transferred;
+            size -= transferred;
+            offset += static_cast<off_t>(transferred);
+            return size == 0;
+        }
+    };
+};
+
+// Fallback backend: a single thread executing pread/pwrite in submission order
+class ThreadIoQueue final : public IoQueue {
+public:
+    ThreadIoQueue()
+        : worker{[this](std::stop_token stop) { run(stop); }} {
+    }
+
+    void read(int fd, char* buffer, std::size_t size, off_t offset, std::size_t tag) override {
+        submit({fd, false, buffer, size, offset, tag});
+    }
+
+    void write(int fd, const char* buffer, std::size_t size, off_t offset, std::size_t tag) override {
+        submit({fd, true, const_cast<char*>(buffer), size, offset, tag});
+    }
+
+    std::size_t wait() override {
+        std::unique_lock lock(mutex);
+        completed_cv.wait(lock, [this] { return !completed.empty(); });
+        auto [tag, error] = completed.front();
+        completed.pop_front();
+        if (error != 0)
+            throw std::system_error(error, std::generic_category(), "I/O request failed");
+        return tag;
+    }
+
+private:
+    void submit(Request request) {
+        {
+            std::lock_guard lock(mutex);
+            pending.push_back(request);
+        }
+        pending_cv.notify_one();
+    }
+
+    void run(std::stop_token stop) {
+        while (true) {
+            Request request{};
+            {
+                std::unique_lock lock(mutex);
+                if (!pending_cv.wait(lock, stop, [this] { return !pending.empty(); }))
+                    return;
+                request = pending.front();
+                pending.pop_front();
+            }
+
+            int error{0};
+            while (request.size > 0) {
+                auto transferred = request.is_write
+                    ? ::pwrite(request.fd, request.buffer, request.size, request.offset)
+                    : ::pread(request.fd, request.buffer, request.size, request.offset);
+                if (transferred < 0 && errno == EINTR)
+                    continue;
+                if (transferred <= 0) {
+                    error = transferred < 0 ? errno : EIO;
+                    break;
+                }
+                request.advance(static_cast<std::size_t>(transferred));
+            }
+
+            {
+                std::lock_guard lock(mutex);
+                completed.emplace_back(request.tag, error);
+            }
+            completed_cv.notify_one();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable_any pending_cv;
+    std::condition_variable completed_cv;
+    std::deque<Request> pending;
+    std::deque<std::pair<std::size_t, int>> completed;
+    std::jthread worker;
+};
+
+#ifdef FPC_HAVE_LIBURING
+
+class UringIoQueue final : public IoQueue {
+public:
+    explicit UringIoQueue(unsigned depth) {
+        if (auto error = ::io_uring_queue_init(depth, &ring, 0); error < 0)
+            throw std::system_error(-error, std::generic_category(), "io_uring_queue_init");
+    }
+
+    ~UringIoQueue() override {
+        ::io_uring_queue_exit(&ring);
+    }
+
+    void read(int fd, char* buffer, std::size_t size, off_t offset, std::size_t tag) override {
+        submit(&in_flight.emplace_back(Request{fd, false, buffer, size, offset, tag}));
+    }
+
+    void write(int fd, const char* buffer, std::size_t size, off_t offset, std::size_t tag) override {
+        submit(&in_flight.emplace_back(Request{fd, true, const_cast<char*>(buffer), size, offset, tag}));
+    }
+
+    std::size_t wait() override {
+        while (true) {
+            io_uring_cqe* cqe{nullptr};
+            if (auto error = ::io_uring_wait_cqe(&ring, &cqe); error < 0) {
+                if (error == -EINTR)
+                    continue;
+                throw std::system_error(-error, std::generic_category(), "io_uring_wait_cqe");
+            }
+            auto* request = static_cast<Request*>(::io_uring_cqe_get_data(cqe));
+            auto result = cqe->res;
+            ::io_uring_cqe_seen(&ring, cqe);
+
+            if (result == -EINTR || result == -EAGAIN) {
+                submit(request);
+                continue;
+            }
+            if (result <= 0)
+                throw std::system_error(result < 0 ? -result : EIO, std::generic_category(), "I/O request failed");
+            if (!request->advance(static_cast<std::size_t>(result))) {
+                submit(request);
+                continue;
+            }
+
+            auto tag = request->tag;
+            in_flight.remove_if([request](const Request& r) { return &r == request; });
+            return tag;
+        }
+    }
+
+private:
+    void submit(Request* request) {
+        auto* sqe = ::io_uring_get_sqe(&ring);
+        if (sqe == nullptr) {
+            ::io_uring_submit(&ring);
+            sqe = ::io_uring_get_sqe(&ring);
+        }
+        if (sqe == nullptr)
+            throw std::system_error(EBUSY, std::generic_category(), "io_uring_get_sqe");
+        if (request->is_write)
+            ::io_uring_prep_write(sqe, request->fd, request->buffer, static_cast<unsigned>(request->size),
+                                  static_cast<std::uint64_t>(request->offset));
+        else
+            ::io_uring_prep_read(sqe, request->fd, request->buffer, static_cast<unsigned>(request->size),
+                                 static_cast<std::uint64_t>(request->offset));
+        ::io_uring_sqe_set_data(sqe, request);
+        if (auto error = ::io_uring_submit(&ring); error < 0)
+            throw std::system_error(-error, std::generic_category(), "io_uring_submit");
+    }
+
+    io_uring ring{};
+    std::list<Request> in_flight;
+};
+
+#endif
+
+inline std::unique_ptr<IoQueue> IoQueue::create([[maybe_unused]] unsigned depth) {
+#ifdef FPC_HAVE_LIBURING
+    try {
+        return std::make_unique<UringIoQueue>(depth);
+    } catch (const std::system_error&) {
+        // Kernel without io_uring or io_uring disabled by seccomp policy
+    }
+#endif
+    return std::make_unique<ThreadIoQueue>();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Thin wrapper over perf_event_open for counting hardware events of the calling thread.
+// Counters that the kernel or the PMU refuses to open are reported as std::nullopt.
+class PerfCounters {
+public:
+    enum Event {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses,
+        LLCMisses,
+        EventCount,
+    };
+
+    struct Sample {
+        std::array<std::optional<double>, EventCount> counts{};
+
+        std::optional<double> operator[](Event event) const {
+            return counts[event];
+        }
+    };
+
+    PerfCounters() {
+        open(Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(L1DMisses, PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        open(LLCMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for (auto fd : fds) {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+
+    [[nodiscard]]
+    bool available() const noexcept {
+        return fds[Cycles] >= 0;
+    }
+
+    void start() noexcept {
+        for (auto fd : fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    // Counts are scaled by time_enabled / time_running to account for counter multiplexing
+    Sample stop() noexcept {
+        Sample sample;
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i] < 0)
+                continue;
+            ::ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            std::array<std::uint64_t, 3> value{};
+            if (::read(fds[i], value.data(), sizeof(value)) != sizeof(value) || value[2] == 0)
+                continue;
+            sample.counts[i] = static_cast<double>(value[0]) * static_cast<double>(value[1]) / static_cast<double>(value[2]);
+        }
+        return sample;
+    }
+
+private:
+    void open(Event event, std::uint32_t type, std::uint64_t config) noexcept {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds[event] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    std::array<int, EventCount> fds{-1, -1, -1, -1, -1};
+};
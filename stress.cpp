@@ -1,8 +1,20 @@
 #include <iostream>
+#include <algorithm>
+#include <array>
 #include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <limits>
 #include <span>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <random>
+#include <chrono>
+#include <cmath>
+#include <memory_resource>
 
 #include "fpc_codec.h"
 
@@ -86,7 +98,974 @@ void DebugTest(std::size_t count) {
     }
 }
 
-int main() {
+// Deterministic round-trip checks of --check, every failed one is printed
+int failed_checks = 0;
+
+void Check(bool condition, std::string_view what) {
+    if (!condition) {
+        std::cout << "FAILED: " << what << std::endl;
+        ++failed_checks;
+    }
+}
+
+template <typename Func>
+bool Rejects(Func&& func) {
+    try {
+        func();
+    } catch (const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+template <typename Float>
+std::vector<Float> RandomWalk(std::size_t count, std::mt19937_64& rnd) {
+    std::normal_distribution<Float> step_dist(0, 1);
+    std::vector<Float> values;
+    values.reserve(count);
+    Float value{0};
+    for (std::size_t i = 0; i < count; ++i) {
+        values.push_back(value += step_dist(rnd));
+    }
+    return values;
+}
+
+bool SameBytes(std::span<const std::byte> lhs, std::span<const std::byte> rhs) {
+    return lhs.size() == rhs.size() && (lhs.empty() || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+template <typename Float>
+std::vector<char> Compress(const DB::CompressionCodecFPC& codec, const std::vector<Float>& values) {
+    auto source_size = static_cast<UInt32>(values.size() * sizeof(Float));
+    std::vector<char> compressed(codec.getMaxCompressedDataSize(source_size));
+    compressed.resize(codec.doCompressData(reinterpret_cast<const char*>(values.data()), source_size, compressed.data()));
+    return compressed;
+}
+
+template <typename Float>
+std::vector<Float> Decompress(
+    const DB::CompressionCodecFPC& codec,
+    const std::vector<char>& compressed,
+    std::size_t count) {
+    std::vector<Float> decoded(count);
+    codec.doDecompressData(
+        compressed.data(), static_cast<UInt32>(compressed.size()), reinterpret_cast<char*>(decoded.data()),
+        static_cast<UInt32>(count * sizeof(Float)));
+    return decoded;
+}
+
+// Batches of 1 to 17 streams of unequal lengths, levels on both sides of the interleaving budget
+template <typename Float>
+void CheckBatch() {
+    std::mt19937_64 rnd{42};
+    for (UInt8 level : {1, 8, 12, 13, 14, 16}) {
+        DB::CompressionCodecFPC codec(sizeof(Float), level);
+        for (std::size_t task_count = 1; task_count <= 17; ++task_count) {
+            std::vector<std::vector<Float>> inputs;
+            std::vector<std::vector<char>> encoded;
+            std::vector<std::vector<Float>> serial;
+            std::vector<std::vector<Float>> batched;
+            std::vector<DB::DecompressionTask> tasks;
+            for (std::size_t i = 0; i < task_count; ++i) {
+                auto& input = inputs.emplace_back(RandomWalk<Float>(i * 37 + task_count % 5, rnd));
+                auto input_size = static_cast<UInt32>(input.size() * sizeof(Float));
+                const auto& compressed = encoded.emplace_back(Compress(codec, input));
+                auto& expected = serial.emplace_back(input.size());
+                codec.doDecompressData(
+                    compressed.data(), static_cast<UInt32>(compressed.size()),
+                    reinterpret_cast<char*>(expected.data()), input_size);
+                batched.emplace_back(input.size());
+            }
+            for (std::size_t i = 0; i < task_count; ++i) {
+                tasks.push_back({encoded[i].data(), static_cast<UInt32>(encoded[i].size()),
+                                 reinterpret_cast<char*>(batched[i].data()),
+                                 static_cast<UInt32>(inputs[i].size() * sizeof(Float))});
+            }
+            codec.doDecompressBatch(tasks);
+            for (std::size_t i = 0; i < task_count; ++i) {
+                Check(SameBytes(std::as_bytes(std::span(serial[i])), std::as_bytes(std::span(inputs[i]))),
+                      "serial decoding restores the input");
+                Check(SameBytes(std::as_bytes(std::span(batched[i])), std::as_bytes(std::span(serial[i]))),
+                      "batch decoding equals serial decoding");
+            }
+        }
+    }
+}
+
+// Round trips over block sizes down to a single value, output independent of the thread count, and frames
+// with altered headers, trailing or missing bytes rejected
+template <typename Float>
+void CheckFrames() {
+    std::mt19937_64 rnd{34};
+    DB::CompressionCodecFPC codec(sizeof(Float), 12);
+    for (std::size_t count : {0, 1, 1001, 5000}) {
+        auto input = RandomWalk<Float>(count, rnd);
+        const auto* source = reinterpret_cast<const char*>(input.data());
+        UInt64 source_size = input.size() * sizeof(Float);
+        for (UInt32 requested_block_size : {0ul, sizeof(Float), 33 * sizeof(Float), 4096ul}) {
+            auto block_size = codec.getFrameBlockSize(requested_block_size);
+            std::vector<char> frame(codec.getMaxCompressedFrameSize(source_size, block_size));
+            frame.resize(codec.doCompressFrame(
+                source, source_size, frame.data(), DB::FrameChecksum::Both, 1, requested_block_size));
+            std::vector<char> threaded(codec.getMaxCompressedFrameSize(source_size, block_size));
+            threaded.resize(codec.doCompressFrame(
+                source, source_size, threaded.data(), DB::FrameChecksum::Both, 4, requested_block_size));
+            Check(threaded == frame, "frame does not depend on the thread count");
+
+            Check(std::memcmp(frame.data(), "FPCF", 4) == 0, "frame starts with the magic");
+            UInt32 header_block_size{0};
+            UInt64 header_uncompressed_size{0};
+            std::memcpy(&header_block_size, frame.data() + 8, sizeof(header_block_size));
+            std::memcpy(&header_uncompressed_size, frame.data() + 12, sizeof(header_uncompressed_size));
+            Check(frame[4] == sizeof(Float) && frame[5] == 12 && frame[7] == static_cast<char>(DB::FrameChecksum::Both),
+                  "frame header holds float width, level and checksum");
+            Check(header_block_size == block_size, "frame header holds the block size");
+            Check(header_uncompressed_size == source_size
+                      && DB::CompressionCodecFPC::getFrameUncompressedSize(frame.data(), frame.size()) == source_size,
+                  "frame header holds the uncompressed size");
+
+            for (unsigned threads : {1, 3}) {
+                std::vector<Float> decoded(count);
+                codec.doDecompressFrame(
+                    frame.data(), frame.size(), reinterpret_cast<char*>(decoded.data()), source_size, threads);
+                Check(SameBytes(std::as_bytes(std::span(decoded)), std::as_bytes(std::span(input))),
+                      "frame decoding restores the input");
+            }
+
+            std::vector<Float> decoded(count);
+            auto* dest = reinterpret_cast<char*>(decoded.data());
+            auto trailing = frame;
+            trailing.push_back(0);
+            Check(Rejects([&] { codec.doDecompressFrame(trailing.data(), trailing.size(), dest, source_size); }),
+                  "frame with trailing data is rejected");
+            for (auto size : {frame.size() - 1, std::size_t{DB::CompressionCodecFPC::FRAME_HEADER_SIZE - 1}}) {
+                Check(Rejects([&] { codec.doDecompressFrame(frame.data(), size, dest, source_size); }),
+                      "truncated frame is rejected");
+            }
+            for (UInt32 wrong_block_size : {0ul, block_size + sizeof(Float) / 2,
+                                            DB::CompressionCodecFPC::MAX_FRAME_BLOCK_SIZE + sizeof(Float)}) {
+                auto altered = frame;
+                std::memcpy(altered.data() + 8, &wrong_block_size, sizeof(wrong_block_size));
+                Check(Rejects([&] { codec.doDecompressFrame(altered.data(), altered.size(), dest, source_size); })
+                          && Rejects([&] { DB::CompressionCodecFPC::getFrameUncompressedSize(
+                                               altered.data(), altered.size()); }),
+                      "frame with an impossible block size is rejected");
+            }
+        }
+    }
+}
+
+// Reference digests of xxHash64 with seed 0, fed whole and byte by byte
+void CheckXxHash64() {
+    std::pair<std::string_view, UInt64> vectors[]{
+        {"", 0xef46db3751d8e999ull},
+        {"a", 0xd24ec4f1a98c6e5bull},
+        {"abc", 0x44bc2cf5ad770999ull},
+        {"Nobody inspects the spammish repetition", 0xfbcea83c8a378bf1ull},
+    };
+    for (auto [input, digest] : vectors) {
+        auto bytes = std::as_bytes(std::span(input));
+        DB::XxHash64 whole;
+        whole.update(bytes);
+        DB::XxHash64 bytewise;
+        for (std::size_t i = 0; i < bytes.size(); ++i) {
+            bytewise.update(bytes.subspan(i, 1));
+        }
+        Check(whole.digest() == digest && bytewise.digest() == digest, "xxHash64 matches the reference digest");
+    }
+}
+
+// A flipped byte in any block payload or stored checksum fails decoding in every mode but FrameChecksum::None
+void CheckFrameChecksums() {
+    std::mt19937_64 rnd{35};
+    DB::CompressionCodecFPC codec(8, 12);
+    auto input = RandomWalk<Float64>(2000, rnd);
+    const auto* source = reinterpret_cast<const char*>(input.data());
+    UInt64 source_size = input.size() * sizeof(Float64);
+    static constexpr UInt32 BLOCK_SIZE{4096};
+    std::vector<Float64> decoded(input.size());
+    auto* dest = reinterpret_cast<char*>(decoded.data());
+    for (auto checksum : {DB::FrameChecksum::None, DB::FrameChecksum::Compressed, DB::FrameChecksum::Uncompressed,
+                          DB::FrameChecksum::Both}) {
+        std::vector<char> frame(codec.getMaxCompressedFrameSize(source_size, BLOCK_SIZE));
+        frame.resize(codec.doCompressFrame(source, source_size, frame.data(), checksum, 1, BLOCK_SIZE));
+        auto checksum_size = std::popcount(static_cast<unsigned>(checksum)) * sizeof(UInt64);
+        for (std::size_t offset = DB::CompressionCodecFPC::FRAME_HEADER_SIZE; offset < frame.size();) {
+            UInt32 payload_size{0};
+            std::memcpy(&payload_size, frame.data() + offset, sizeof(payload_size));
+            auto payload = offset + sizeof(payload_size);
+            for (auto position : {payload, payload + payload_size / 2, payload + payload_size - 1,
+                                  payload + payload_size + checksum_size - 1}) {
+                auto corrupted = frame;
+                corrupted[position] = static_cast<char>(corrupted[position] ^ 0x10);
+                bool rejected = Rejects([&] {
+                    codec.doDecompressFrame(corrupted.data(), corrupted.size(), dest, source_size);
+                });
+                Check(rejected || checksum == DB::FrameChecksum::None, "flipped byte of a frame block is detected");
+            }
+            offset = payload + payload_size + checksum_size;
+        }
+    }
+
+    std::vector<char> frame(codec.getMaxCompressedFrameSize(source_size));
+    auto unknown = static_cast<DB::FrameChecksum>(4);
+    std::vector<DB::FrameBlockTask> tasks{{source, static_cast<UInt32>(source_size), frame.data(), 0}};
+    Check(Rejects([&] { codec.doCompressFrame(source, source_size, frame.data(), unknown); })
+              && Rejects([&] { codec.doCompressFrameHeader(source_size, frame.data(), unknown); })
+              && Rejects([&] { codec.doCompressFrameBlocks(tasks, unknown); }),
+          "unknown frame checksum is rejected");
+}
+
+// The bytes a prefix needs are the stream of its values rounded up to whole pairs. Sources are exact
+// allocations of those bytes, a stream truncated there and one claiming to go on past the allocation,
+// so that sanitizer builds catch reads beyond them
+template <typename Float>
+void CheckPrefix() {
+    std::mt19937_64 rnd{39};
+    auto input = RandomWalk<Float>(1000, rnd);
+    for (UInt8 level : {1, 12}) {
+        DB::CompressionCodecFPC codec(sizeof(Float), level);
+        auto compressed_size = static_cast<UInt32>(Compress(codec, input).size());
+        for (std::size_t max_values : {1, 2, 63, 64, 501}) {
+            auto pair_values = max_values + max_values % 2;
+            auto stream = Compress(codec, std::vector<Float>(input.begin(), input.begin() + pair_values));
+            // Compress leaves the capacity of the worst case, a copy allocates the exact size
+            std::vector<char> needed(stream.begin(), stream.end());
+            auto needed_size = static_cast<UInt32>(needed.size());
+            for (auto source_size : {needed_size, compressed_size}) {
+                std::vector<Float> prefix(max_values);
+                auto count = codec.decompressPrefix(
+                    needed.data(), source_size, reinterpret_cast<char*>(prefix.data()), static_cast<UInt32>(max_values));
+                Check(count == max_values, "decompressPrefix decodes the requested values");
+                Check(SameBytes(std::as_bytes(std::span(prefix)), std::as_bytes(std::span(input).first(max_values))),
+                      "decompressPrefix restores the prefix from the bytes it needs");
+            }
+        }
+    }
+}
+
+// Values of the first field of 16-byte records compress exactly like the same values stored contiguously
+template <typename Float>
+void CheckStrided() {
+    static constexpr std::size_t STRIDE{16};
+    std::mt19937_64 rnd{40};
+    for (UInt8 level : {1, 12, 20}) {
+        DB::CompressionCodecFPC codec(sizeof(Float), level);
+        for (std::size_t count : {0, 1, 2, 3, 63, 999, 1000}) {
+            auto input = RandomWalk<Float>(count, rnd);
+            std::vector<char> records(count * STRIDE, 'x');
+            for (std::size_t i = 0; i < count; ++i) {
+                std::memcpy(records.data() + i * STRIDE, &input[i], sizeof(Float));
+            }
+            auto contiguous = Compress(codec, input);
+            std::vector<char> strided(codec.getMaxCompressedDataSize(static_cast<UInt32>(count * sizeof(Float))));
+            strided.resize(codec.doCompressStrided(records.data(), STRIDE, static_cast<UInt32>(count), strided.data()));
+            Check(strided == contiguous, "strided encoding equals contiguous encoding");
+
+            std::vector<char> decoded(count * STRIDE, 'x');
+            codec.doDecompressStrided(
+                strided.data(), static_cast<UInt32>(strided.size()), decoded.data(), STRIDE, static_cast<UInt32>(count));
+            Check(decoded == records, "strided decoding restores the records");
+        }
+    }
+}
+
+// Chunks of decompressChunks concatenate to the output of doDecompressData, all but the last one full.
+// Generators abandoned after the first chunk must release their frame
+template <typename Float, std::size_t ChunkSize>
+void CheckChunks(const DB::CompressionCodecFPC& codec, const std::vector<Float>& input) {
+    auto compressed = Compress(codec, input);
+    auto compressed_size = static_cast<UInt32>(compressed.size());
+    auto input_size = static_cast<UInt32>(input.size() * sizeof(Float));
+    auto expected = Decompress<Float>(codec, compressed, input.size());
+    std::vector<Float> chunks;
+    bool full_chunks{true};
+    for (auto chunk : codec.decompressChunks<Float, ChunkSize>(compressed.data(), compressed_size, input_size)) {
+        full_chunks = full_chunks && chunks.size() % ChunkSize == 0 && !chunk.empty() && chunk.size() <= ChunkSize;
+        chunks.insert(chunks.end(), chunk.begin(), chunk.end());
+    }
+    Check(full_chunks, "decompressChunks yields full chunks but the last one");
+    Check(SameBytes(std::as_bytes(std::span(chunks)), std::as_bytes(std::span(expected))),
+          "decompressChunks equals doDecompressData");
+
+    std::vector<Float> first;
+    for (auto chunk : codec.decompressChunks<Float, ChunkSize>(compressed.data(), compressed_size, input_size)) {
+        first.assign(chunk.begin(), chunk.end());
+        break;
+    }
+    Check(SameBytes(std::as_bytes(std::span(first)),
+                    std::as_bytes(std::span(expected).first(std::min(ChunkSize, expected.size())))),
+          "decompressChunks stopped after the first chunk yields it");
+}
+
+template <typename Float>
+void CheckChunks() {
+    std::mt19937_64 rnd{43};
+    DB::CompressionCodecFPC codec(sizeof(Float), 12);
+    for (std::size_t count : {0, 1, 2, 7, 63, 64, 65, 1001}) {
+        auto input = RandomWalk<Float>(count, rnd);
+        CheckChunks<Float, 64>(codec, input);
+        CheckChunks<Float, 6>(codec, input);
+        CheckChunks<Float, 2>(codec, input);
+    }
+}
+
+// decodedView under std::ranges algorithms and the fused aggregates must agree with doDecompressData.
+// find_if runs on exactly the pairs up to its hit, so sanitizer builds catch decoding past it
+template <typename Float>
+void CheckDecodedView(const DB::CompressionCodecFPC& codec, const std::vector<Float>& input) {
+    auto compressed = Compress(codec, input);
+    auto compressed_size = static_cast<UInt32>(compressed.size());
+    auto input_size = static_cast<UInt32>(input.size() * sizeof(Float));
+    auto expected = Decompress<Float>(codec, compressed, input.size());
+    auto view = [&] { return codec.decodedView<Float>(compressed.data(), compressed_size, input_size); };
+    auto same_bits = [](Float lhs, Float rhs) { return std::memcmp(&lhs, &rhs, sizeof(Float)) == 0; };
+
+    std::vector<Float> viewed;
+    std::ranges::copy(view(), std::back_inserter(viewed));
+    Check(SameBytes(std::as_bytes(std::span(viewed)), std::as_bytes(std::span(expected))),
+          "decodedView equals doDecompressData");
+
+    std::vector<Float> taken;
+    std::ranges::copy(view() | std::views::take(5), std::back_inserter(taken));
+    Check(SameBytes(std::as_bytes(std::span(taken)),
+                    std::as_bytes(std::span(expected).first(std::min<std::size_t>(5, expected.size())))),
+          "views::take of decodedView yields the leading values");
+
+    auto threshold = expected.empty() ? Float{0} : expected[expected.size() / 2];
+    auto above = [threshold](Float value) { return value > threshold; };
+    std::vector<Float> filtered;
+    std::ranges::copy(view() | std::views::filter(above), std::back_inserter(filtered));
+    Check(std::ranges::equal(filtered, expected | std::views::filter(above)),
+          "views::filter of decodedView yields the matching values");
+
+    auto hit = std::ranges::find_if(expected, above);
+    if (hit == expected.end()) {
+        auto found = view();
+        Check(std::ranges::find_if(found, above) == found.end(), "find_if on decodedView finds no value");
+    } else {
+        auto hit_index = static_cast<std::size_t>(hit - expected.begin());
+        auto needed_count = std::min(hit_index / 2 * 2 + 2, input.size());
+        auto stream = Compress(codec, std::vector<Float>(input.begin(), input.begin() + needed_count));
+        std::vector<char> needed(stream.begin(), stream.end());
+        auto found = codec.decodedView<Float>(needed.data(), compressed_size, input_size);
+        auto found_value = std::ranges::find_if(found, above);
+        Check(found_value != found.end() && same_bits(*found_value, *hit),
+              "find_if on decodedView stops at the first match");
+    }
+
+    Float64 sum{0};
+    Float64 sum_abs{0};
+    auto min = std::numeric_limits<Float>::infinity();
+    auto max = -std::numeric_limits<Float>::infinity();
+    std::vector<UInt64> bitmap(codec.getSelectionBitmapSize(input_size));
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        sum += expected[i];
+        sum_abs += std::abs(expected[i]);
+        min = std::min(min, expected[i]);
+        max = std::max(max, expected[i]);
+        if (above(expected[i])) {
+            bitmap[i / 64] |= UInt64{1} << (i % 64);
+        }
+    }
+    auto selected_count = static_cast<UInt64>(std::ranges::count_if(expected, above));
+    Check(std::abs(codec.decompressSum<Float>(compressed.data(), compressed_size, input_size) - sum) <= 1e-9 * sum_abs,
+          "decompressSum equals the sum of doDecompressData");
+    Check(same_bits(codec.decompressMin<Float>(compressed.data(), compressed_size, input_size), min)
+              && same_bits(codec.decompressMax<Float>(compressed.data(), compressed_size, input_size), max),
+          "decompressMin and decompressMax equal the ones of doDecompressData");
+    Check(codec.decompressCountIf<Float>(compressed.data(), compressed_size, input_size, above) == selected_count,
+          "decompressCountIf equals count_if of doDecompressData");
+    std::vector<UInt64> selected(bitmap.size(), ~UInt64{0});
+    Check(codec.decompressSelect<Float>(compressed.data(), compressed_size, input_size, above, selected.data())
+                  == selected_count
+              && selected == bitmap,
+          "decompressSelect marks the matches of doDecompressData");
+    std::vector<UInt64> filter_bitmap(bitmap.size(), ~UInt64{0});
+    Check(codec.decompressFilter<Float>(
+              compressed.data(), compressed_size, input_size, DB::Comparison::Greater, threshold, filter_bitmap.data())
+                  == selected_count
+              && filter_bitmap == bitmap,
+          "decompressFilter marks the matches of doDecompressData");
+}
+
+template <typename Float>
+void CheckDecodedView() {
+    std::mt19937_64 rnd{44};
+    for (UInt8 level : {1, 12}) {
+        DB::CompressionCodecFPC codec(sizeof(Float), level);
+        for (std::size_t count : {0, 1, 2, 3, 64, 1001}) {
+            CheckDecodedView(codec, RandomWalk<Float>(count, rnd));
+        }
+    }
+}
+
+// Estimates start from the snapshot like the streams do, large inputs are sampled within a few percent
+void CheckEstimate() {
+    std::mt19937_64 rnd{31};
+    auto training = RandomWalk<Float64>(8192, rnd);
+    auto snapshot = DB::PredictorSnapshot::train(
+        8, 12, 31, reinterpret_cast<const char*>(training.data()),
+        static_cast<UInt32>(training.size() * sizeof(Float64)));
+    DB::CompressionCodecFPC snapshot_codec(snapshot);
+    std::vector<Float64> repeated(training.begin(), training.begin() + 1000);
+    auto compressed = Compress(snapshot_codec, repeated);
+    Check(snapshot_codec.estimateCompressedSize(
+              reinterpret_cast<const char*>(repeated.data()), static_cast<UInt32>(repeated.size() * sizeof(Float64)))
+                  .compressed_size
+              == compressed.size(),
+          "estimate of a fully measured input starts from the snapshot");
+
+    static constexpr std::size_t LARGE_COUNT{300000};
+    auto walk = RandomWalk<Float64>(LARGE_COUNT, rnd);
+    std::vector<Float64> prices;
+    for (auto value : walk) {
+        prices.push_back(std::nearbyint(value * 100) / 100 + 0.0);
+    }
+    auto walk32 = RandomWalk<Float32>(LARGE_COUNT, rnd);
+    DB::CompressionCodecFPC codec(8, 16, DB::BlockEncodings::Decimal | DB::BlockEncodings::Downcast);
+    DB::CompressionCodecFPC codec32(4, 16);
+    auto check = [](const DB::CompressionCodecFPC& estimated, const auto& input) {
+        auto real = static_cast<double>(Compress(estimated, input).size());
+        auto estimate = estimated.estimateCompressedSize(
+            reinterpret_cast<const char*>(input.data()), static_cast<UInt32>(input.size() * sizeof(input[0])));
+        Check(std::abs(estimate.compressed_size - real) < 0.05 * real, "estimate of a sampled input is within 5%");
+    };
+    check(codec, walk);
+    check(codec, prices);
+    check(codec32, walk32);
+
+    // Value 1000 lies between the first two windows, only a full pass would see it is not a decimal
+    auto sampled_prices = prices;
+    sampled_prices[1000] = 1.0 / 3;
+    auto sampled_size = static_cast<UInt32>(sampled_prices.size() * sizeof(Float64));
+    Check(codec.estimateCompressedSize(reinterpret_cast<const char*>(sampled_prices.data()), sampled_size)
+                  .compressed_size
+              < Compress(codec, sampled_prices).size() / 2,
+          "encodings of a sampled input are chosen on the sampled windows");
+}
+
+// On a plain stream every pair is a header byte and the two value tails, the histogram gives their sizes
+template <typename Float>
+void CheckStatistics() {
+    std::mt19937_64 rnd{30};
+    for (UInt8 level : {1, 12, 20}) {
+        DB::CompressionCodecFPC codec(sizeof(Float), level);
+        for (std::size_t count : {0, 1, 2, 999, 4096}) {
+            auto input = RandomWalk<Float>(count, rnd);
+            auto input_size = static_cast<UInt32>(input.size() * sizeof(Float));
+            DB::EncoderStatistics statistics;
+            std::vector<char> compressed(codec.getMaxCompressedDataSize(input_size));
+            compressed.resize(codec.doCompressData(
+                reinterpret_cast<const char*>(input.data()), input_size, compressed.data(), statistics));
+            UInt64 histogram_values = 0;
+            UInt64 tail_bytes = 0;
+            for (unsigned encoded_size = 0; encoded_size < statistics.encoded_size_histogram.size(); ++encoded_size) {
+                auto zero_bytes = sizeof(Float) == 8 && encoded_size > 3 ? encoded_size + 1 : encoded_size;
+                histogram_values += statistics.encoded_size_histogram[encoded_size];
+                tail_bytes += statistics.encoded_size_histogram[encoded_size] * (sizeof(Float) - zero_bytes);
+            }
+            auto pairs = (count + 1) / 2;
+            Check(statistics.values == 2 * pairs, "statistics count both values of every pair");
+            Check(statistics.dfcm_wins + statistics.fcm_wins == statistics.values, "every value has one predictor");
+            Check(histogram_values == statistics.values, "histogram counts every value");
+            Check(statistics.bytes == pairs + tail_bytes, "payload is the pair headers and value tails");
+            Check(DB::CompressionCodecFPC::HEADER_SIZE + pairs + tail_bytes == compressed.size(),
+                  "header, pair headers and value tails make up the stream");
+        }
+    }
+}
+
+// Decodes from exactly uncompressed_size + margin bytes, the allocation is exact so that sanitizer builds catch
+// accesses past it. A buffer one byte smaller must be rejected.
+template <typename Float>
+void CheckInPlace(const DB::CompressionCodecFPC& codec, const std::vector<Float>& input, UInt8 header_flag) {
+    auto compressed = Compress(codec, input);
+    Check((static_cast<UInt8>(compressed[2]) & header_flag) == header_flag, "stream has the expected encoding");
+
+    auto input_size = static_cast<UInt32>(input.size() * sizeof(Float));
+    auto compressed_size = static_cast<UInt32>(compressed.size());
+    auto buffer_size = input_size + codec.getInPlaceDecompressionMargin(input_size);
+    std::vector<char> buffer(buffer_size);
+    std::memcpy(buffer.data() + buffer_size - compressed_size, compressed.data(), compressed_size);
+    codec.doDecompressInPlace(buffer.data(), buffer_size, compressed_size, input_size);
+    Check(SameBytes(std::as_bytes(std::span(buffer).first(input_size)), std::as_bytes(std::span(input))),
+          "in-place decoding restores the input");
+
+    bool rejected{false};
+    try {
+        codec.doDecompressInPlace(buffer.data(), buffer_size - 1, compressed_size, input_size);
+    } catch (const std::exception&) {
+        rejected = true;
+    }
+    Check(rejected, "in-place decoding rejects a buffer below the margin");
+}
+
+// Plain, snapshot, decimal and downcast streams of odd value counts, incompressible inputs included
+void CheckInPlace() {
+    std::mt19937_64 rnd{45};
+    auto random_bits = [&rnd]<typename Float>(std::size_t count) {
+        std::vector<Float> values(count);
+        for (auto& value : values) {
+            value = std::bit_cast<Float>(static_cast<std::conditional_t<sizeof(Float) == 8, UInt64, UInt32>>(rnd()));
+        }
+        return values;
+    };
+    auto snapshot_input = RandomWalk<Float64>(4096, rnd);
+    auto snapshot = DB::PredictorSnapshot::train(
+        8, 12, 7, reinterpret_cast<const char*>(snapshot_input.data()), 4096 * sizeof(Float64));
+    DB::CompressionCodecFPC snapshot_codec(snapshot);
+    DB::CompressionCodecFPC decimal_codec(8, 12, DB::BlockEncodings::Decimal);
+    DB::CompressionCodecFPC downcast_codec(8, 12, DB::BlockEncodings::Downcast);
+    for (std::size_t count : {1, 3, 63, 65, 1001}) {
+        for (UInt8 level : {1, 12, 20}) {
+            DB::CompressionCodecFPC codec64(8, level);
+            DB::CompressionCodecFPC codec32(4, level);
+            CheckInPlace(codec64, RandomWalk<Float64>(count, rnd), 0);
+            CheckInPlace(codec64, random_bits.operator()<Float64>(count), 0);
+            CheckInPlace(codec32, RandomWalk<Float32>(count, rnd), 0);
+            CheckInPlace(codec32, random_bits.operator()<Float32>(count), 0);
+        }
+        CheckInPlace(snapshot_codec, RandomWalk<Float64>(count, rnd), DB::SNAPSHOT_HEADER_FLAG);
+
+        std::vector<Float64> prices;
+        std::vector<Float64> integers;
+        std::vector<Float64> widened;
+        std::uniform_int_distribution<std::int64_t> integer_dist(-(std::int64_t{1} << 52), std::int64_t{1} << 52);
+        for (auto value : RandomWalk<Float64>(count, rnd)) {
+            // -0.0 has no decimal representation and would keep the block plain
+            prices.push_back(std::nearbyint(value * 100) / 100 + 0.0);
+            integers.push_back(static_cast<Float64>(integer_dist(rnd)));
+            widened.push_back(static_cast<Float32>(value));
+        }
+        CheckInPlace(decimal_codec, prices, DB::DECIMAL_HEADER_FLAG);
+        CheckInPlace(decimal_codec, integers, DB::DECIMAL_HEADER_FLAG);
+        CheckInPlace(downcast_codec, widened, DB::DOWNCAST_HEADER_FLAG);
+    }
+}
+
+std::vector<char> Serialize(const DB::AppendState& state) {
+    std::vector<char> serialized(state.getSerializedSize());
+    state.serialize(serialized.data());
+    return serialized;
+}
+
+// Appends parts one by one through a serialized state. After every part the stream must equal doCompressData
+// of the values so far, and recoverAppendState of it must equal the state kept by the encoder
+template <typename Float>
+void CheckAppend(const DB::CompressionCodecFPC& codec, const std::vector<std::size_t>& part_sizes, std::mt19937_64& rnd) {
+    std::size_t total_count{0};
+    for (auto part_size : part_sizes) {
+        total_count += part_size;
+    }
+    auto values = RandomWalk<Float>(total_count, rnd);
+    std::vector<char> stream(codec.getMaxCompressedDataSize(static_cast<UInt32>(total_count * sizeof(Float))));
+
+    DB::AppendState state;
+    UInt32 stream_size{0};
+    std::size_t count{0};
+    for (auto part_size : part_sizes) {
+        const auto* part = reinterpret_cast<const char*>(values.data() + count);
+        auto part_bytes = static_cast<UInt32>(part_size * sizeof(Float));
+        if (count == 0) {
+            stream_size = codec.doCompressData(part, part_bytes, stream.data(), state);
+        } else {
+            auto serialized = Serialize(state);
+            auto restored = DB::AppendState::deserialize(serialized.data(), serialized.size());
+            Check(Serialize(restored) == serialized, "append state survives serialization");
+            stream_size = codec.doAppendData(part, part_bytes, stream.data(), restored);
+            state = std::move(restored);
+        }
+        count += part_size;
+
+        std::vector<Float> prefix(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(count));
+        auto expected = Compress(codec, prefix);
+        Check(SameBytes(std::as_bytes(std::span(stream).first(stream_size)), std::as_bytes(std::span(expected))),
+              "appended stream equals doCompressData of all values");
+        Check(state.getCompressedSize() == stream_size, "append state holds the stream size");
+        auto recovered = codec.recoverAppendState(stream.data(), stream_size, static_cast<UInt32>(count * sizeof(Float)));
+        Check(Serialize(recovered) == Serialize(state), "recovered append state equals the kept one");
+    }
+}
+
+// Odd and empty parts leave a pending value or append onto one
+void CheckAppend() {
+    std::mt19937_64 rnd{47};
+    std::vector<std::vector<std::size_t>> part_sizes{
+        {1}, {0, 1}, {1, 1, 1}, {3, 5, 0, 7}, {2, 2}, {64, 1, 63, 1000}, {65, 129, 1}, {1001, 3}};
+    auto snapshot_input = RandomWalk<Float64>(4096, rnd);
+    auto snapshot = DB::PredictorSnapshot::train(
+        8, 10, 9, reinterpret_cast<const char*>(snapshot_input.data()), 4096 * sizeof(Float64));
+    DB::CompressionCodecFPC snapshot_codec(snapshot);
+    for (const auto& sizes : part_sizes) {
+        for (UInt8 level : {1, 12}) {
+            CheckAppend<Float64>(DB::CompressionCodecFPC(8, level), sizes, rnd);
+            CheckAppend<Float32>(DB::CompressionCodecFPC(4, level), sizes, rnd);
+        }
+        CheckAppend<Float64>(snapshot_codec, sizes, rnd);
+    }
+}
+
+// Every decoder of the stream must restore the exact bits of input, aggregates must equal the ones of a plain stream
+void CheckEncodedBlock(
+    DB::BlockEncodings encodings,
+    UInt8 level,
+    const std::vector<Float64>& input,
+    UInt8 header_flag) {
+    DB::CompressionCodecFPC codec(8, level, encodings);
+    auto input_bytes = std::as_bytes(std::span(input));
+    auto input_size = static_cast<UInt32>(input.size() * sizeof(Float64));
+    auto compressed = Compress(codec, input);
+    auto compressed_size = static_cast<UInt32>(compressed.size());
+    Check((static_cast<UInt8>(compressed[2]) & DB::BLOCK_ENCODING_HEADER_FLAGS) == header_flag,
+          "stream has the expected encoding");
+    auto decoded = Decompress<Float64>(codec, compressed, input.size());
+    Check(SameBytes(std::as_bytes(std::span(decoded)), input_bytes), "doDecompressData restores the input");
+
+    DB::EncoderStatistics statistics;
+    std::vector<char> with_statistics(codec.getMaxCompressedDataSize(input_size));
+    with_statistics.resize(codec.doCompressData(
+        reinterpret_cast<const char*>(input.data()), input_size, with_statistics.data(), statistics));
+    auto header_size = DB::CompressionCodecFPC::HEADER_SIZE + (header_flag == DB::DECIMAL_HEADER_FLAG ? 1 : 0);
+    Check(with_statistics == compressed, "statistics do not change the stream");
+    Check(statistics.values == input.size() + input.size() % 2, "statistics count every encoded value");
+    Check(statistics.bytes + header_size == compressed.size(), "statistics count every payload byte");
+    Check(codec.estimateCompressedSize(reinterpret_cast<const char*>(input.data()), input_size).compressed_size
+              == compressed.size(),
+          "estimate of a fully measured input is exact");
+
+    std::vector<Float64> for_each;
+    codec.decompressForEach<Float64>(compressed.data(), compressed_size, input_size, [&](std::span<const Float64> chunk) {
+        for_each.insert(for_each.end(), chunk.begin(), chunk.end());
+    });
+    Check(SameBytes(std::as_bytes(std::span(for_each)), input_bytes), "decompressForEach restores the input");
+
+    std::vector<Float64> chunks;
+    for (auto chunk : codec.decompressChunks<Float64>(compressed.data(), compressed_size, input_size)) {
+        chunks.insert(chunks.end(), chunk.begin(), chunk.end());
+    }
+    Check(SameBytes(std::as_bytes(std::span(chunks)), input_bytes), "decompressChunks restores the input");
+    std::vector<Float64> viewed;
+    for (auto value : codec.decodedView<Float64>(compressed.data(), compressed_size, input_size)) {
+        viewed.push_back(value);
+    }
+    Check(SameBytes(std::as_bytes(std::span(viewed)), input_bytes), "decodedView restores the input");
+
+    // Odd counts are padded by one value: zero, or the last value repeated by a decimal block
+    auto padded_count = input.size() + input.size() % 2;
+    std::vector<Float64> prefix(padded_count + 1);
+    auto prefix_count = codec.decompressPrefix(
+        compressed.data(), compressed_size, reinterpret_cast<char*>(prefix.data()), static_cast<UInt32>(prefix.size()));
+    Check(prefix_count == padded_count, "decompressPrefix stops at the end of the stream");
+    Check(SameBytes(std::as_bytes(std::span(prefix).first(input.size())), input_bytes),
+          "decompressPrefix restores the input");
+    if (input.size() % 2 != 0) {
+        auto padding = header_flag == DB::DECIMAL_HEADER_FLAG ? input.back() : 0.0;
+        Check(std::bit_cast<UInt64>(prefix[input.size()]) == std::bit_cast<UInt64>(padding),
+              "decompressPrefix yields the padding");
+    }
+
+    std::vector<Float64> strided(2 * input.size(), 42.0);
+    codec.doDecompressStrided(
+        compressed.data(), compressed_size, reinterpret_cast<char*>(strided.data()), 2 * sizeof(Float64),
+        static_cast<UInt32>(input.size()));
+    bool strided_matches{true};
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        strided_matches = strided_matches && std::bit_cast<UInt64>(strided[2 * i]) == std::bit_cast<UInt64>(input[i])
+            && strided[2 * i + 1] == 42.0;
+    }
+    Check(strided_matches, "doDecompressStrided restores the input between untouched values");
+
+    DB::CompressionCodecFPC plain_codec(8, level);
+    auto plain = Compress(plain_codec, input);
+    auto plain_size = static_cast<UInt32>(plain.size());
+    auto same_bits = [](auto lhs, auto rhs) { return std::bit_cast<UInt64>(lhs) == std::bit_cast<UInt64>(rhs); };
+    Check(same_bits(codec.decompressSum<Float64>(compressed.data(), compressed_size, input_size),
+                    plain_codec.decompressSum<Float64>(plain.data(), plain_size, input_size)),
+          "decompressSum equals the one of a plain stream");
+    Check(same_bits(codec.decompressMin<Float64>(compressed.data(), compressed_size, input_size),
+                    plain_codec.decompressMin<Float64>(plain.data(), plain_size, input_size)),
+          "decompressMin equals the one of a plain stream");
+    Check(same_bits(codec.decompressMax<Float64>(compressed.data(), compressed_size, input_size),
+                    plain_codec.decompressMax<Float64>(plain.data(), plain_size, input_size)),
+          "decompressMax equals the one of a plain stream");
+    std::vector<UInt64> bitmap(codec.getSelectionBitmapSize(input_size));
+    std::vector<UInt64> plain_bitmap(bitmap.size());
+    auto selected = codec.decompressFilter<Float64>(
+        compressed.data(), compressed_size, input_size, DB::Comparison::Less, 0.0, bitmap.data());
+    auto plain_selected = plain_codec.decompressFilter<Float64>(
+        plain.data(), plain_size, input_size, DB::Comparison::Less, 0.0, plain_bitmap.data());
+    Check(selected == plain_selected && bitmap == plain_bitmap, "decompressFilter equals the one of a plain stream");
+}
+
+// Sources are arbitrary bytes, choosing and applying an encoding must not assume Float64 alignment
+void CheckMisalignedSource(DB::BlockEncodings encodings, const std::vector<Float64>& input) {
+    DB::CompressionCodecFPC codec(8, 12, encodings);
+    auto input_size = static_cast<UInt32>(input.size() * sizeof(Float64));
+    std::vector<char> source(input_size + 1);
+    std::memcpy(source.data() + 1, input.data(), input_size);
+    std::vector<char> compressed(codec.getMaxCompressedDataSize(input_size));
+    compressed.resize(codec.doCompressData(source.data() + 1, input_size, compressed.data()));
+    Check(compressed == Compress(codec, input), "misaligned source compresses as an aligned one");
+    Check(codec.estimateCompressedSize(source.data() + 1, input_size).compressed_size == compressed.size(),
+          "misaligned source is estimated as an aligned one");
+}
+
+// Values on both sides of what the encodings accept: -0.0, NaNs with and without payload, integers near 2^53
+void CheckBlockEncodings() {
+    constexpr auto TWO_TO_53 = 0x1p53;
+    const auto quiet_nan = std::numeric_limits<Float64>::quiet_NaN();
+    const auto payload_nan = std::bit_cast<Float64>(UInt64{0x7ff8000000000123});
+    const auto both = DB::BlockEncodings::Decimal | DB::BlockEncodings::Downcast;
+    std::mt19937_64 rnd{49};
+    for (std::size_t count : {1, 3, 65, 1001}) {
+        std::vector<Float64> prices;
+        std::vector<Float64> near_limit;
+        std::vector<Float64> powers_of_two;
+        std::vector<Float64> past_limit;
+        std::vector<Float64> negative_zeros;
+        std::vector<Float64> quiet_nans;
+        std::vector<Float64> payload_nans;
+        for (auto value : RandomWalk<Float64>(count, rnd)) {
+            auto i = static_cast<Float64>(prices.size());
+            auto sign = prices.size() % 2 == 0 ? 1.0 : -1.0;
+            auto half = std::nearbyint(value * 2) / 2 + 0.0;
+            prices.push_back(std::nearbyint(value * 100) / 100 + 0.0);
+            near_limit.push_back(sign * (TWO_TO_53 - 1 - i));
+            powers_of_two.push_back(prices.size() % 3 == 0 ? sign * TWO_TO_53 : half);
+            past_limit.push_back(TWO_TO_53 + 2 * i);
+            negative_zeros.push_back(prices.size() % 3 == 0 ? -0.0 : half);
+            quiet_nans.push_back(prices.size() % 3 == 0 ? sign * quiet_nan : half);
+            payload_nans.push_back(prices.size() % 3 == 0 ? payload_nan : half);
+        }
+        // The first value is the only one set for a single value
+        negative_zeros.front() = -0.0;
+        quiet_nans.front() = quiet_nan;
+        payload_nans.front() = payload_nan;
+        powers_of_two.front() = TWO_TO_53;
+        for (UInt8 level : {1, 12}) {
+            CheckEncodedBlock(both, level, prices, DB::DECIMAL_HEADER_FLAG);
+            CheckEncodedBlock(both, level, near_limit, DB::DECIMAL_HEADER_FLAG);
+            CheckEncodedBlock(both, level, powers_of_two, DB::DOWNCAST_HEADER_FLAG);
+            CheckEncodedBlock(both, level, past_limit, count == 1 ? DB::DOWNCAST_HEADER_FLAG : 0);
+            CheckEncodedBlock(both, level, negative_zeros, DB::DOWNCAST_HEADER_FLAG);
+            CheckEncodedBlock(both, level, quiet_nans, DB::DOWNCAST_HEADER_FLAG);
+            CheckEncodedBlock(both, level, payload_nans, 0);
+            CheckEncodedBlock(DB::BlockEncodings::Decimal, level, negative_zeros, 0);
+        }
+        CheckMisalignedSource(both, prices);
+        CheckMisalignedSource(both, powers_of_two);
+    }
+}
+
+template <typename Int>
+void CheckIntegerRoundTrip(const std::vector<Int>& input, std::string_view what) {
+    auto input_size = static_cast<UInt32>(input.size() * sizeof(Int));
+    for (auto transform : {DB::IntegerTransform::None, DB::IntegerTransform::Delta, DB::IntegerTransform::DeltaOfDelta}) {
+        for (UInt8 level : {1, 12}) {
+            DB::CompressionCodecFPCInteger codec(sizeof(Int), level, transform);
+            std::vector<char> compressed(codec.getMaxCompressedDataSize(input_size));
+            auto compressed_size = codec.doCompressData(
+                reinterpret_cast<const char*>(input.data()), input_size, compressed.data());
+            std::vector<Int> decoded(input.size());
+            codec.doDecompressData(
+                compressed.data(), compressed_size, reinterpret_cast<char*>(decoded.data()), input_size);
+            Check(decoded == input, what);
+        }
+    }
+}
+
+// Every transform on both widths, deltas and deltas of deltas wrapping around the integer range included
+template <typename Int>
+void CheckIntegers() {
+    constexpr auto MIN = std::numeric_limits<Int>::min();
+    constexpr auto MAX = std::numeric_limits<Int>::max();
+    std::mt19937_64 rnd{48};
+    for (std::size_t count : {0, 1, 3, 65, 1001}) {
+        std::vector<Int> timestamps;
+        std::vector<Int> extremes;
+        std::vector<Int> random;
+        Int timestamp{1'600'000'000};
+        for (std::size_t i = 0; i < count; ++i) {
+            timestamps.push_back(timestamp += static_cast<Int>(rnd() % 3));
+            random.push_back(static_cast<Int>(rnd()));
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            static constexpr std::array<Int, 6> EXTREMES{MAX, MIN, MAX, Int{0}, MIN, static_cast<Int>(MAX - 1)};
+            extremes.push_back(EXTREMES[i % EXTREMES.size()]);
+        }
+        CheckIntegerRoundTrip(timestamps, "integer round trip of timestamps");
+        CheckIntegerRoundTrip(extremes, "integer round trip wrapping at the range ends");
+        CheckIntegerRoundTrip(random, "integer round trip of random integers");
+    }
+}
+
+// Global allocations of at least a predictor table at CheckMemoryResource's level, which must all go through
+// the resource given to the codec. Test buffers stay below the threshold
+constexpr std::size_t LARGE_ALLOCATION_SIZE{1 << 20};
+std::size_t large_global_allocations = 0;
+
+void* CountedAllocate(std::size_t size, std::size_t alignment) {
+    if (size >= LARGE_ALLOCATION_SIZE) {
+        ++large_global_allocations;
+    }
+    size = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+    if (void* pointer = std::aligned_alloc(alignment, size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    return CountedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+// Counts what the codec allocates, bypassing global new so it is not counted above
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations{0};
+    std::size_t live_bytes{0};
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        live_bytes += bytes;
+        return std::aligned_alloc(alignment, (std::max<std::size_t>(bytes, 1) + alignment - 1) / alignment * alignment);
+    }
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t) override {
+        live_bytes -= bytes;
+        std::free(pointer);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Every entry point allocating predictor tables, with level 18 tables of several MiB
+void CheckMemoryResource() {
+    static constexpr UInt8 LEVEL{18};
+    static constexpr std::size_t COUNT{4097};
+    std::mt19937_64 rnd{26};
+    auto values = RandomWalk<Float64>(COUNT, rnd);
+    std::vector<Float64> prices;
+    for (auto value : values) {
+        prices.push_back(std::nearbyint(value * 100) / 100 + 0.0);
+    }
+    const auto* source = reinterpret_cast<const char*>(values.data());
+    auto source_size = static_cast<UInt32>(COUNT * sizeof(Float64));
+    std::vector<Float64> decoded(COUNT + 1);
+    auto* dest = reinterpret_cast<char*>(decoded.data());
+
+    CountingResource resource;
+    large_global_allocations = 0;
+    {
+        DB::CompressionCodecFPC codec(8, LEVEL, &resource);
+        auto compressed = Compress(codec, values);
+        auto compressed_size = static_cast<UInt32>(compressed.size());
+        codec.doDecompressData(compressed.data(), compressed_size, dest, source_size);
+        codec.decompressPrefix(compressed.data(), compressed_size, dest, 100);
+        codec.doDecompressStrided(compressed.data(), compressed_size, dest, sizeof(Float64), COUNT);
+        codec.decompressSum<Float64>(compressed.data(), compressed_size, source_size);
+        for ([[maybe_unused]] auto value : codec.decodedView<Float64>(compressed.data(), compressed_size, source_size)) {
+        }
+        std::vector<DB::DecompressionTask> tasks(3, {compressed.data(), compressed_size, dest, source_size});
+        codec.doDecompressBatch(tasks);
+        codec.estimateCompressedSize(source, source_size);
+
+        std::vector<char> frame(codec.getMaxCompressedFrameSize(source_size, 8192));
+        auto frame_size = codec.doCompressFrame(source, source_size, frame.data(), DB::FrameChecksum::Both, 2, 8192);
+        codec.doDecompressFrame(frame.data(), frame_size, dest, source_size, 2);
+
+        DB::AppendState state;
+        std::vector<char> stream(codec.getMaxCompressedDataSize(source_size));
+        auto half = static_cast<UInt32>(COUNT / 2 * sizeof(Float64));
+        codec.doCompressData(source, half, stream.data(), state);
+        auto stream_size = codec.doAppendData(source + half, source_size - half, stream.data(), state);
+        auto recovered = codec.recoverAppendState(stream.data(), stream_size, source_size);
+        std::pmr::vector<char> serialized(recovered.getSerializedSize(), &resource);
+        recovered.serialize(serialized.data());
+        state = DB::AppendState::deserialize(serialized.data(), serialized.size(), &resource);
+
+        auto snapshot = DB::PredictorSnapshot::train(8, LEVEL, 1, source, source_size, &resource);
+        DB::CompressionCodecFPC snapshot_codec(snapshot, &resource);
+        auto snapshot_compressed = Compress(snapshot_codec, values);
+        snapshot_codec.doDecompressData(
+            snapshot_compressed.data(), static_cast<UInt32>(snapshot_compressed.size()), dest, source_size);
+        std::pmr::vector<char> serialized_snapshot(snapshot.getSerializedSize(), &resource);
+        snapshot.serialize(serialized_snapshot.data());
+        DB::PredictorSnapshot::deserialize(serialized_snapshot.data(), serialized_snapshot.size(), &resource);
+
+        DB::CompressionCodecFPC encoding_codec(8, LEVEL, DB::BlockEncodings::Decimal, &resource);
+        auto decimal = Compress(encoding_codec, prices);
+        encoding_codec.doDecompressData(decimal.data(), static_cast<UInt32>(decimal.size()), dest, source_size);
+        encoding_codec.estimateCompressedSize(reinterpret_cast<const char*>(prices.data()), source_size);
+
+        DB::CompressionCodecFPCInteger integer_codec(8, LEVEL, DB::IntegerTransform::Delta, &resource);
+        std::vector<char> integers(integer_codec.getMaxCompressedDataSize(source_size));
+        auto integers_size = integer_codec.doCompressData(source, source_size, integers.data());
+        integer_codec.doDecompressData(integers.data(), integers_size, dest, source_size);
+    }
+    Check(resource.allocations > 0, "predictor tables are allocated from the codec's resource");
+    Check(resource.live_bytes == 0, "everything allocated from the codec's resource is freed");
+    Check(large_global_allocations == 0, "no predictor table is allocated by global new");
+}
+
+int RunChecks() {
+    CheckBatch<Float64>();
+    CheckBatch<Float32>();
+    CheckStatistics<Float64>();
+    CheckStatistics<Float32>();
+    CheckEstimate();
+    CheckFrames<Float64>();
+    CheckFrames<Float32>();
+    CheckXxHash64();
+    CheckFrameChecksums();
+    CheckPrefix<Float64>();
+    CheckPrefix<Float32>();
+    CheckStrided<Float64>();
+    CheckStrided<Float32>();
+    CheckChunks<Float64>();
+    CheckChunks<Float32>();
+    CheckDecodedView<Float64>();
+    CheckDecodedView<Float32>();
+    CheckInPlace();
+    CheckAppend();
+    CheckBlockEncodings();
+    CheckIntegers<std::int64_t>();
+    CheckIntegers<std::int32_t>();
+    CheckMemoryResource();
+    std::cout << "ISA: " << DB::CompressionCodecFPC::getDispatchedIsa() << ", failed checks: " << failed_checks
+              << std::endl;
+    return failed_checks == 0 ? 0 : 1;
+}
+
+// --check runs the deterministic checks once, otherwise random round trips are repeated forever
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view(argv[1]) == "--check") {
+        return RunChecks();
+    }
     while (true) {
         SingleTest();
     }